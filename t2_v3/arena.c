@@ -0,0 +1,321 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include "define.h"
+/***********************************************************************
+ * arena.c written by DSU_410 team ...
+ *
+ * Description: Grid storage.  Buffers are mapped straight from the OS,
+ * on 2MB pages when possible, and kept for reuse when released, so
+ * grids, tuner copies and pipeline buffers are mapped once per process
+ * instead of once per use.
+ *
+ * Backing, tried in order for requests of at least HUGE_PAGE_SIZE:
+ * 1.) explicit huge pages (MAP_HUGETLB, needs pages reserved in
+ *     /proc/sys/vm/nr_hugepages)
+ * 2.) transparent huge pages: a 2MB aligned mapping with
+ *     madvise(MADV_HUGEPAGE)
+ * 3.) normal pages
+ * Smaller requests always use normal pages.  T2_HUGEPAGES=0 in the
+ * environment skips 1 and 2.
+ *
+ * Reuse: arenaRelease keeps the block mapped.  arenaAcquire hands out
+ * the smallest free block that is large enough before mapping a new
+ * one.
+ *
+ * NOTES:
+ * - ARENA_LOCK guards the block table: the daemon's runner thread
+ *   acquires pipeline buffers while the poll loop formats MEMORY.
+ * - Transparent huge pages are requested, not guaranteed; the kernel
+ *   may still back the mapping with normal pages.  arenaReport shows
+ *   both the requested blocks and the bytes actually on huge pages.
+ ***********************************************************************/
+
+#define BACKING_NORMAL      0
+#define BACKING_TRANSPARENT 1
+#define BACKING_EXPLICIT    2
+
+typedef struct
+{
+    void *ptr;
+    size_t size;                // mapped bytes
+    int backing;
+    int inUse;
+} Block;
+
+static Block BLOCKS[MAX_ARENA_BLOCKS];
+static int NUM_BLOCKS = 0;
+static pthread_mutex_t ARENA_LOCK = PTHREAD_MUTEX_INITIALIZER;
+
+// Footprint and reuse counters for arenaReport
+static size_t BYTES_IN_USE = 0;
+static size_t PEAK_IN_USE = 0;
+static long ACQUIRES = 0;
+static long REUSES = 0;
+
+/*****************************  roundUp  *****************************
+ * size_t roundUp(size_t bytes, size_t unit)
+ *
+ * Description: Rounds bytes up to a multiple of unit.
+ ***********************************************************************/
+static size_t roundUp(size_t bytes, size_t unit)
+{
+    return (bytes + unit - 1) / unit * unit;
+}
+
+/*****************************  mapBlock  *****************************
+ * void *mapBlock(size_t bytes, size_t *size, int *backing)
+ *
+ * Description: Maps a new block of at least bytes, see the backing
+ * order at the top of this file.
+ *
+ * Parameter    Direction   Description
+ * --------------------------------------------------------------------
+ * bytes        in          requested size
+ * size         out         size actually mapped
+ * backing      out         BACKING_EXPLICIT, _TRANSPARENT or _NORMAL
+ *
+ * NOTES:
+ * - Returns NULL if even normal pages can't be mapped.
+ ***********************************************************************/
+static void *mapBlock(size_t bytes, size_t *size, int *backing)
+{
+    void *ptr;
+    const char *env = getenv("T2_HUGEPAGES");
+    int tryHuge = bytes >= HUGE_PAGE_SIZE && !(env != NULL && strcmp(env, "0") == 0);
+
+    if (tryHuge)
+    {
+        *size = roundUp(bytes, HUGE_PAGE_SIZE);
+#ifdef MAP_HUGETLB
+        ptr = mmap(NULL, *size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (ptr != MAP_FAILED)
+        {
+            *backing = BACKING_EXPLICIT;
+            return ptr;
+        }
+#endif
+#ifdef MADV_HUGEPAGE
+        {
+            // over-map by one huge page, then trim to a 2MB aligned block
+            size_t padded = *size + HUGE_PAGE_SIZE;
+            char *raw = mmap(NULL, padded, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (raw != MAP_FAILED)
+            {
+                char *aligned = (char *) roundUp((uintptr_t) raw, HUGE_PAGE_SIZE);
+                size_t head = aligned - raw;
+                if (head > 0)
+                    munmap(raw, head);
+                munmap(aligned + *size, padded - head - *size);
+                // without THP support the block still works on normal pages
+                *backing = (madvise(aligned, *size, MADV_HUGEPAGE) == 0)
+                           ? BACKING_TRANSPARENT : BACKING_NORMAL;
+                return aligned;
+            }
+        }
+#endif
+    }
+
+    *size = roundUp(bytes, (size_t) sysconf(_SC_PAGESIZE));
+    ptr = mmap(NULL, *size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+        return NULL;
+    *backing = BACKING_NORMAL;
+    return ptr;
+}
+
+/*****************************  arenaAcquire  *****************************
+ * void *arenaAcquire(size_t bytes)
+ *
+ * Description: Returns a zero-filled buffer of at least bytes.
+ *
+ * Process:
+ * 1.) Take the smallest free block that fits, clearing it.
+ * 2.) Otherwise map a new block (fresh mappings are already zero).
+ *
+ * Parameter    Direction   Description
+ * --------------------------------------------------------------------
+ * bytes        in          requested size
+ *
+ * NOTES:
+ * - Returns NULL when out of memory or out of block slots
+ *   (MAX_ARENA_BLOCKS).
+ * - Zero filling keeps the calloc behavior grids rely on for their
+ *   perimeter.
+ ***********************************************************************/
+void *arenaAcquire(size_t bytes)
+{
+    int k;
+    int best = -1;
+    Block *block = NULL;
+    void *ptr = NULL;
+
+    pthread_mutex_lock(&ARENA_LOCK);
+    ACQUIRES++;
+    for (k = 0; k < NUM_BLOCKS; k++)
+    {
+        if (!BLOCKS[k].inUse && BLOCKS[k].size >= bytes &&
+            (best == -1 || BLOCKS[k].size < BLOCKS[best].size))
+            best = k;
+    }
+
+    if (best != -1)
+    {
+        block = &BLOCKS[best];
+        memset(block->ptr, 0, bytes);
+        REUSES++;
+    }
+    else if (NUM_BLOCKS < MAX_ARENA_BLOCKS)
+    {
+        block = &BLOCKS[NUM_BLOCKS];
+        block->ptr = mapBlock(bytes, &block->size, &block->backing);
+        if (block->ptr != NULL)
+            NUM_BLOCKS++;
+    }
+
+    if (block != NULL && block->ptr != NULL)
+    {
+        block->inUse = 1;
+        BYTES_IN_USE += block->size;
+        if (BYTES_IN_USE > PEAK_IN_USE)
+            PEAK_IN_USE = BYTES_IN_USE;
+        ptr = block->ptr;
+    }
+    pthread_mutex_unlock(&ARENA_LOCK);
+    return ptr;
+}
+
+/*****************************  arenaRelease  *****************************
+ * void arenaRelease(void *ptr)
+ *
+ * Description: Gives a buffer back for reuse.  The block stays mapped
+ * until arenaDestroy.  NULL is ignored.
+ ***********************************************************************/
+void arenaRelease(void *ptr)
+{
+    int k;
+    pthread_mutex_lock(&ARENA_LOCK);
+    for (k = 0; ptr != NULL && k < NUM_BLOCKS; k++)
+    {
+        if (BLOCKS[k].ptr == ptr && BLOCKS[k].inUse)
+        {
+            BLOCKS[k].inUse = 0;
+            BYTES_IN_USE -= BLOCKS[k].size;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&ARENA_LOCK);
+}
+
+/*****************************  thpBackedBytes  *****************************
+ * long long thpBackedBytes(void)
+ *
+ * Description: Bytes of BACKING_TRANSPARENT blocks the kernel has
+ * actually put on huge pages, summed from the AnonHugePages lines of
+ * /proc/self/smaps for every mapping that overlaps such a block.
+ *
+ * NOTES:
+ * - Returns -1 where /proc/self/smaps is not available (not Linux).
+ * - Call with ARENA_LOCK held.
+ * - The kernel may merge a block with a neighboring mapping, so each
+ *   mapping's count is capped at the block bytes it overlaps.
+ ***********************************************************************/
+static long long thpBackedBytes(void)
+{
+    int k;
+    char line[MAX_LINE];
+    unsigned long start, end, lo, hi;
+    unsigned long overlap = 0;  // block bytes in the current mapping
+    long kb;
+    long long total = 0;
+    FILE *in = fopen("/proc/self/smaps", "r");
+
+    if (in == NULL)
+        return -1;
+    while (fgets(line, sizeof(line), in) != NULL)
+    {
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2)
+        {
+            // a mapping header line, e.g. "7f00...-7f00... rw-p ..."
+            overlap = 0;
+            for (k = 0; k < NUM_BLOCKS; k++)
+            {
+                if (BLOCKS[k].backing != BACKING_TRANSPARENT)
+                    continue;
+                lo = (uintptr_t) BLOCKS[k].ptr;
+                hi = lo + BLOCKS[k].size;
+                if (lo < end && hi > start)
+                    overlap += (hi < end ? hi : end) - (lo > start ? lo : start);
+            }
+        }
+        else if (overlap > 0 && sscanf(line, "AnonHugePages: %ld kB", &kb) == 1)
+        {
+            total += ((unsigned long) kb * 1024 < overlap) ? kb * 1024LL
+                                                           : (long long) overlap;
+        }
+    }
+    fclose(in);
+    return total;
+}
+
+/*****************************  arenaReport  *****************************
+ * void arenaReport(char *buf, int size)
+ *
+ * Description: Formats memory footprint, page backing and reuse counts
+ * as one line (without newline), for -m and the daemon's MEMORY reply.
+ *
+ * Parameter    Direction   Description
+ * --------------------------------------------------------------------
+ * buf          out         receives the line
+ * size         in          size of buf
+ *
+ * NOTES:
+ * - thp_requested counts blocks advised with MADV_HUGEPAGE,
+ *   thp_backed_bytes is how much of them is really on huge pages
+ *   (-1 when unknown, see thpBackedBytes).
+ * - MAX_LINE bytes is always enough for the line.
+ ***********************************************************************/
+void arenaReport(char *buf, int size)
+{
+    int k;
+    size_t mapped = 0;
+    int count[3] = {0, 0, 0};
+
+    pthread_mutex_lock(&ARENA_LOCK);
+    for (k = 0; k < NUM_BLOCKS; k++)
+    {
+        mapped += BLOCKS[k].size;
+        count[BLOCKS[k].backing]++;
+    }
+    snprintf(buf, size, "arena mapped_bytes %zu in_use_bytes %zu peak_bytes %zu "
+             "blocks %d explicit_2mb %d thp_requested %d thp_backed_bytes %lld "
+             "normal_%ldk %d acquires %ld reused %ld",
+             mapped, BYTES_IN_USE, PEAK_IN_USE, NUM_BLOCKS,
+             count[BACKING_EXPLICIT], count[BACKING_TRANSPARENT],
+             thpBackedBytes(), sysconf(_SC_PAGESIZE) / 1024,
+             count[BACKING_NORMAL], ACQUIRES, REUSES);
+    pthread_mutex_unlock(&ARENA_LOCK);
+}
+
+/*****************************  arenaDestroy  *****************************
+ * void arenaDestroy(void)
+ *
+ * Description: Unmaps every block, in use or not.
+ ***********************************************************************/
+void arenaDestroy(void)
+{
+    int k;
+    pthread_mutex_lock(&ARENA_LOCK);
+    for (k = 0; k < NUM_BLOCKS; k++)
+        munmap(BLOCKS[k].ptr, BLOCKS[k].size);
+    NUM_BLOCKS = 0;
+    BYTES_IN_USE = 0;
+    pthread_mutex_unlock(&ARENA_LOCK);
+}
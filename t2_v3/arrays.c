@@ -86,6 +86,33 @@ void fillRandomly(int rows, int cols, int arr[][cols])
     }
 }
 
+/*************************  clearPerimeter  ****************************
+ * void clearPerimeter(int rows, int cols, int arr[][cols])
+ *
+ * Description: Sets the outer rows and columns of arr to 0, leaving the
+ * interior alone.
+ *
+ * Parameter    Direction   Description
+ * ---------------------------------------------------------------------
+ * rows         in          total number of rows in array
+ * cols         in          total number of columns in array
+ * arr          in/out      array whose border is cleared
+ ***********************************************************************/
+void clearPerimeter(int rows, int cols, int arr[][cols])
+{
+    int i;
+    for (i = 0; i < cols; i++)
+    {
+        arr[0][i] = 0;
+        arr[rows - 1][i] = 0;
+    }
+    for (i = 0; i < rows; i++)
+    {
+        arr[i][0] = 0;
+        arr[i][cols - 1] = 0;
+    }
+}
+
 /****************************   print  ********************************
  * void print(int rows, int cols, int arr[][cols])
  *
@@ -105,16 +132,122 @@ void fillRandomly(int rows, int cols, int arr[][cols])
  *   for 2D array appear in parameter list before arrays.
  ***********************************************************************/
 void print(int rows, int cols, int arr[][cols])
+{
+    fprintArray(stdout, rows, cols, arr);
+}
+
+/**************************   fprintArray  *****************************
+ * void fprintArray(FILE *out, int rows, int cols, int arr[][cols])
+ *
+ * Description: Same layout as print, but written to any open stream.
+ * Used by the daemon when a job asks for its output in a file.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * out           in          stream receiving the printed array
+ * rows          in          total number of rows in arr
+ * cols          in          total number of columns in arr
+ * arr           in          printed array
+ ***********************************************************************/
+void fprintArray(FILE *out, int rows, int cols, int arr[][cols])
 {
     int i;
     int j;
-    printf("\n");
+    fprintf(out, "\n");
     for (i = 0; i < rows; i++)
     {
         for (j = 0; j < cols; j++)
         {
-            printf("%-6d", arr[i][j]);
+            fprintf(out, "%-6d", arr[i][j]);
         }
-        printf("\n\n");
+        fprintf(out, "\n\n");
+    }
+}
+
+/**************************   loadSnapshot  ****************************
+ * int loadSnapshot(const char *path, int rows, int cols, int arr[][cols])
+ *
+ * Description: Reads a grid previously written by saveSnapshot.
+ *
+ * Process:
+ * 1.) Read the "rows cols" header and make sure it matches.
+ * 2.) Read rows * cols whitespace separated integers into arr.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * path          in          snapshot file
+ * rows          in          total number of rows in arr
+ * cols          in          total number of columns in arr
+ * arr           out         receives the stored values
+ *
+ * NOTES:
+ * - Returns 0 on success, ERROR_FILE if the file can't be read and
+ *   ERROR_DIMENSION_SIZE if its dimensions differ from rows x cols.
+ * - The perimeter is stored too, so it is loaded as written.
+ ***********************************************************************/
+int loadSnapshot(const char *path, int rows, int cols, int arr[][cols])
+{
+    int i, j;
+    int fileRows, fileCols;
+    FILE *in = fopen(path, "r");
+    if (in == NULL)
+        return ERROR_FILE;
+    
+    if (fscanf(in, "%d %d", &fileRows, &fileCols) != 2)
+    {
+        fclose(in);
+        return ERROR_FILE;
+    }
+    if (fileRows != rows || fileCols != cols)
+    {
+        fclose(in);
+        return ERROR_DIMENSION_SIZE;
+    }
+    
+    for (i = 0; i < rows; i++)
+    {
+        for (j = 0; j < cols; j++)
+        {
+            if (fscanf(in, "%d", &arr[i][j]) != 1)
+            {
+                fclose(in);
+                return ERROR_FILE;
+            }
+        }
+    }
+    fclose(in);
+    return 0;
+}
+
+/**************************   saveSnapshot  ****************************
+ * int saveSnapshot(const char *path, int rows, int cols, int arr[][cols])
+ *
+ * Description: Writes arr in the format read back by loadSnapshot,
+ * a "rows cols" header followed by one line per row.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * path          in          snapshot file, truncated if it exists
+ * rows          in          total number of rows in arr
+ * cols          in          total number of columns in arr
+ * arr           in          values to store
+ *
+ * NOTES:
+ * - Returns 0 on success, ERROR_FILE otherwise.
+ ***********************************************************************/
+int saveSnapshot(const char *path, int rows, int cols, int arr[][cols])
+{
+    int i, j;
+    FILE *out = fopen(path, "w");
+    if (out == NULL)
+        return ERROR_FILE;
+    
+    fprintf(out, "%d %d\n", rows, cols);
+    for (i = 0; i < rows; i++)
+    {
+        for (j = 0; j < cols; j++)
+            fprintf(out, "%d ", arr[i][j]);
+        fprintf(out, "\n");
     }
+    return (fclose(out) == 0) ? 0 : ERROR_FILE;
 }
@@ -2,7 +2,10 @@
 #define define_h
 
 // Threads
+// NUM_THREADS is the default, -t or a tuned profile can pick any count
+// up to MAX_THREADS
 #define NUM_THREADS 5
+#define MAX_THREADS 64
 
 // Important generation data
 #define TOTAL_GENERATIONS 4
@@ -14,14 +17,125 @@
 // statically declared array for testing, make sure M and N are
 // correct
 #define OFFSET 2
-#define M 3 + OFFSET
-#define N 3 + OFFSET
+#define M (3 + OFFSET)
+#define N (3 + OFFSET)
 
 // Used with rand() to determine range [0, RANGE)
 #define RANGE 20
 
+// Daemon mode limits
+#define MAX_CLIENTS     16      // simultaneous socket connections
+#define MAX_QUEUED_JOBS 32      // jobs waiting per client
+#define MAX_LINE        512     // longest request line accepted
+#define MAX_PATH_LEN    256     // snapshot and output file paths
+
+// Per-generation statistics (-s file)
+// Value histogram bin k counts values [k * HIST_WIDTH, (k + 1) * HIST_WIDTH),
+// the last bin also counts everything larger
+#define HIST_BINS   16
+#define HIST_WIDTH  4
+
+// newValue rule branches, in order of precedence
+#define RULE_ZERO       0   // sum % 10 == 0
+#define RULE_ADD        1   // sum under 50
+#define RULE_SUBTRACT   2   // sum between 50 and 150
+#define RULE_ONE        3   // sum over 150
+#define NUM_RULES       4
+
+// Aggregates of one generation's new values.  Aligned to a cache line
+// so per-thread copies in an array don't share lines.
+typedef struct
+{
+    long long sum;
+    long zeros;
+    long hist[HIST_BINS];
+    long rules[NUM_RULES];
+} __attribute__((aligned(64))) GenStats;
+
+// Autotuner (-a)
+#define TUNE_GENERATIONS    5       // timed generations per candidate
+#define PROFILE_NAME        ".t2_v3_profile"  // in $HOME unless -p is given
+
+// Grid arena
+#define HUGE_PAGE_SIZE      (2 * 1024 * 1024)
+#define MAX_ARENA_BLOCKS    64
+
+// Compute/print pipeline: grids in rotation, so printing may fall up to
+// PIPELINE_DEPTH - 1 generations behind before computing waits
+#define PIPELINE_DEPTH      3
+
+// Errors
+#define GENERIC_ERROR_CODE      10
+#define ERROR_DIMENSION_SIZE    11
+#define ERROR_FILE              12
+
+// arrays.c
 void copyArray(int rows, int cols, int arr1[][cols], int arr2[][cols]);
 void fillRandomly(int rows, int cols, int arr[][cols]);
 void print(int rows, int cols, int arr[][cols]);
+void fprintArray(FILE *out, int rows, int cols, int arr[][cols]);
+void clearPerimeter(int rows, int cols, int arr[][cols]);
+int loadSnapshot(const char *path, int rows, int cols, int arr[][cols]);
+int saveSnapshot(const char *path, int rows, int cols, int arr[][cols]);
+
+// Row kernels compute the new values of one row from the previous
+// generation's rows above, at and below it
+typedef void (*RowKernel)(const int *above, const int *row, const int *below, int *out);
+
+typedef struct
+{
+    const char *name;
+    RowKernel run;
+    int (*supported)(void);     // nonzero if this CPU can run it
+} KernelInfo;
+
+// kernels.c
+extern const KernelInfo KERNELS[];
+extern const int NUM_KERNELS;
+extern RowKernel ROW_KERNEL;
+extern const char *ROW_KERNEL_NAME;
+int validateKernel(RowKernel kernel);
+int selectKernel(const char *name);
+
+// arena.c
+void *arenaAcquire(size_t bytes);
+void arenaRelease(void *ptr);
+void arenaReport(char *buf, int size);
+void arenaDestroy(void);
+
+// tune.c
+void autotune(int tuneKernel, int tuneThreads, int tuneChunk);
+int loadProfile(const char *path);
+int saveProfile(const char *path);
+
+// pipeline.c
+int simulatePipelined(int generations, FILE *out);
+
+// stats.c
+void clearStats(GenStats *stats);
+void addStats(GenStats *total, const GenStats *part);
+void writeStatsHeader(FILE *out);
+void writeStatsRow(FILE *out, int generation, const GenStats *stats);
+
+// main.c
+extern int (*A)[N];
+extern int (*B)[N];
+extern int IN_PLACE;
+extern int THREAD_COUNT;
+extern int CHUNK_ROWS;
+void spinUpThreads(void);
+void computeGeneration(void);
+void spinDownThreads(void);
+void simulate(int generations, FILE *out);
+void writeGenerationStats(void);
+extern int CURRENT_GENERATION;
+void freeGrids(void);
+void updateRow(const int *above, const int *row, const int *below, int *out);
+void updateRowFrom(const int *above, const int *row, const int *below, int *out, int first);
+extern FILE *STATS_OUT;
+
+// server.c
+long long nowMicros(void);
+int runServer(const char *socketPath);
 
 #endif /* define_h */
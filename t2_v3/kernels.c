@@ -0,0 +1,339 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "define.h"
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define X86_KERNELS 1
+#include <immintrin.h>
+#endif
+/***********************************************************************
+ * kernels.c written by DSU_410 team ...
+ *
+ * Description: Row kernels for the update pass, selected at startup.
+ * Every kernel computes the same thing as updateRow in main.c (the
+ * scalar reference).  The SIMD variants are compiled with per-function
+ * target attributes, so one binary runs on any x86 host and only uses
+ * the instructions the host supports.
+ *
+ * Selection (selectKernel):
+ * 1.) A kernel named by -k or the T2_KERNEL environment variable wins,
+ *     if the CPU supports it.
+ * 2.) Otherwise the first kernel in KERNELS (fastest first) the CPU
+ *     supports.
+ * 3.) Either way the kernel has to match updateRow on random rows
+ *     (validateKernel) before it is used.
+ *
+ * Vector rules:
+ * -sum % 10 == 0 is tested as sum == (sum / 10) * 10 with the quotient
+ *  from a float division, exact for sums below 2^20 (cell sums here
+ *  stay far below that).
+ * -Rules are applied lowest precedence first, each one overwriting the
+ *  lanes where it fires, so the result matches the if/else chain in
+ *  newValue.
+ * -Columns left over after the last full vector go through
+ *  updateRowFrom.
+ ***********************************************************************/
+
+RowKernel ROW_KERNEL = updateRow;
+const char *ROW_KERNEL_NAME = "scalar";
+
+static int scalarSupported(void)
+{
+    return 1;
+}
+
+#ifdef X86_KERNELS
+
+static int sse2Supported(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+}
+
+static int avx2Supported(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+static int avx512Supported(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f");
+}
+
+/*****************************  updateRowSSE2  *****************************
+ * void updateRowSSE2(const int *above, const int *row, const int *below,
+ *                    int *out)
+ *
+ * Description: updateRow, 4 cells at a time.  SSE2 has no 32-bit max or
+ * blend, so both are built from compare and and/andnot/or.
+ ***********************************************************************/
+__attribute__((target("sse2")))
+static void updateRowSSE2(const int *above, const int *row, const int *below, int *out)
+{
+    int j;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i three = _mm_set1_epi32(3);
+    const __m128i fifty = _mm_set1_epi32(50);
+    const __m128i oneFifty = _mm_set1_epi32(150);
+    const __m128 ten = _mm_set1_ps(10.0f);
+    __m128i sum, cell, q, value, mask, sub;
+
+    for (j = 1; j + 4 <= N - 1; j += 4)
+    {
+        sum = _mm_add_epi32(_mm_add_epi32(
+                  _mm_add_epi32(_mm_loadu_si128((const __m128i *) &above[j - 1]),
+                                _mm_loadu_si128((const __m128i *) &above[j])),
+                  _mm_add_epi32(_mm_loadu_si128((const __m128i *) &above[j + 1]),
+                                _mm_loadu_si128((const __m128i *) &row[j - 1]))),
+              _mm_add_epi32(
+                  _mm_add_epi32(_mm_loadu_si128((const __m128i *) &row[j + 1]),
+                                _mm_loadu_si128((const __m128i *) &below[j - 1])),
+                  _mm_add_epi32(_mm_loadu_si128((const __m128i *) &below[j]),
+                                _mm_loadu_si128((const __m128i *) &below[j + 1]))));
+        cell = _mm_loadu_si128((const __m128i *) &row[j]);
+        sum = _mm_add_epi32(sum, cell);
+
+        // Over 150: 1
+        value = one;
+        // Over 50: subtract 3, can't go negative
+        sub = _mm_sub_epi32(cell, three);
+        sub = _mm_andnot_si128(_mm_cmplt_epi32(sub, zero), sub);
+        mask = _mm_and_si128(_mm_cmpgt_epi32(sum, fifty), _mm_cmplt_epi32(sum, oneFifty));
+        value = _mm_or_si128(_mm_and_si128(mask, sub), _mm_andnot_si128(mask, value));
+        // Under 50: add 3
+        mask = _mm_cmplt_epi32(sum, fifty);
+        value = _mm_or_si128(_mm_and_si128(mask, _mm_add_epi32(cell, three)),
+                             _mm_andnot_si128(mask, value));
+        // % 10 == 0: 0
+        q = _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(sum), ten));
+        q = _mm_add_epi32(_mm_slli_epi32(q, 3), _mm_slli_epi32(q, 1));
+        value = _mm_andnot_si128(_mm_cmpeq_epi32(sum, q), value);
+
+        _mm_storeu_si128((__m128i *) &out[j], value);
+    }
+    updateRowFrom(above, row, below, out, j);
+}
+
+/*****************************  updateRowAVX2  *****************************
+ * void updateRowAVX2(const int *above, const int *row, const int *below,
+ *                    int *out)
+ *
+ * Description: updateRow, 8 cells at a time.
+ ***********************************************************************/
+__attribute__((target("avx2")))
+static void updateRowAVX2(const int *above, const int *row, const int *below, int *out)
+{
+    int j;
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i three = _mm256_set1_epi32(3);
+    const __m256i fifty = _mm256_set1_epi32(50);
+    const __m256i oneFifty = _mm256_set1_epi32(150);
+    const __m256 ten = _mm256_set1_ps(10.0f);
+    __m256i sum, cell, q, value, mask;
+
+    for (j = 1; j + 8 <= N - 1; j += 8)
+    {
+        sum = _mm256_add_epi32(_mm256_add_epi32(
+                  _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) &above[j - 1]),
+                                   _mm256_loadu_si256((const __m256i *) &above[j])),
+                  _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) &above[j + 1]),
+                                   _mm256_loadu_si256((const __m256i *) &row[j - 1]))),
+              _mm256_add_epi32(
+                  _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) &row[j + 1]),
+                                   _mm256_loadu_si256((const __m256i *) &below[j - 1])),
+                  _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) &below[j]),
+                                   _mm256_loadu_si256((const __m256i *) &below[j + 1]))));
+        cell = _mm256_loadu_si256((const __m256i *) &row[j]);
+        sum = _mm256_add_epi32(sum, cell);
+
+        // Over 150: 1
+        value = _mm256_set1_epi32(1);
+        // Over 50: subtract 3, can't go negative
+        mask = _mm256_and_si256(_mm256_cmpgt_epi32(sum, fifty),
+                                _mm256_cmpgt_epi32(oneFifty, sum));
+        value = _mm256_blendv_epi8(value, _mm256_max_epi32(_mm256_sub_epi32(cell, three), zero), mask);
+        // Under 50: add 3
+        mask = _mm256_cmpgt_epi32(fifty, sum);
+        value = _mm256_blendv_epi8(value, _mm256_add_epi32(cell, three), mask);
+        // % 10 == 0: 0
+        q = _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(sum), ten));
+        q = _mm256_add_epi32(_mm256_slli_epi32(q, 3), _mm256_slli_epi32(q, 1));
+        value = _mm256_andnot_si256(_mm256_cmpeq_epi32(sum, q), value);
+
+        _mm256_storeu_si256((__m256i *) &out[j], value);
+    }
+    updateRowFrom(above, row, below, out, j);
+}
+
+/****************************  updateRowAVX512  ****************************
+ * void updateRowAVX512(const int *above, const int *row, const int *below,
+ *                      int *out)
+ *
+ * Description: updateRow, 16 cells at a time, using mask registers
+ * for the rules.
+ ***********************************************************************/
+__attribute__((target("avx512f")))
+static void updateRowAVX512(const int *above, const int *row, const int *below, int *out)
+{
+    int j;
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i three = _mm512_set1_epi32(3);
+    const __m512i fifty = _mm512_set1_epi32(50);
+    const __m512i oneFifty = _mm512_set1_epi32(150);
+    const __m512 ten = _mm512_set1_ps(10.0f);
+    __m512i sum, cell, q, value;
+    __mmask16 mask;
+
+    for (j = 1; j + 16 <= N - 1; j += 16)
+    {
+        sum = _mm512_add_epi32(_mm512_add_epi32(
+                  _mm512_add_epi32(_mm512_loadu_si512(&above[j - 1]),
+                                   _mm512_loadu_si512(&above[j])),
+                  _mm512_add_epi32(_mm512_loadu_si512(&above[j + 1]),
+                                   _mm512_loadu_si512(&row[j - 1]))),
+              _mm512_add_epi32(
+                  _mm512_add_epi32(_mm512_loadu_si512(&row[j + 1]),
+                                   _mm512_loadu_si512(&below[j - 1])),
+                  _mm512_add_epi32(_mm512_loadu_si512(&below[j]),
+                                   _mm512_loadu_si512(&below[j + 1]))));
+        cell = _mm512_loadu_si512(&row[j]);
+        sum = _mm512_add_epi32(sum, cell);
+
+        // Over 150: 1
+        value = _mm512_set1_epi32(1);
+        // Over 50: subtract 3, can't go negative
+        mask = _mm512_cmpgt_epi32_mask(sum, fifty) & _mm512_cmplt_epi32_mask(sum, oneFifty);
+        value = _mm512_mask_mov_epi32(value, mask,
+                                      _mm512_max_epi32(_mm512_sub_epi32(cell, three), zero));
+        // Under 50: add 3
+        mask = _mm512_cmplt_epi32_mask(sum, fifty);
+        value = _mm512_mask_mov_epi32(value, mask, _mm512_add_epi32(cell, three));
+        // % 10 == 0: 0
+        q = _mm512_cvttps_epi32(_mm512_div_ps(_mm512_cvtepi32_ps(sum), ten));
+        q = _mm512_add_epi32(_mm512_slli_epi32(q, 3), _mm512_slli_epi32(q, 1));
+        mask = _mm512_cmpeq_epi32_mask(sum, q);
+        value = _mm512_mask_mov_epi32(value, mask, zero);
+
+        _mm512_storeu_si512(&out[j], value);
+    }
+    updateRowFrom(above, row, below, out, j);
+}
+
+#endif /* X86_KERNELS */
+
+// Fastest first, selectKernel picks the first supported one
+const KernelInfo KERNELS[] = {
+#ifdef X86_KERNELS
+    { "avx512", updateRowAVX512, avx512Supported },
+    { "avx2",   updateRowAVX2,   avx2Supported },
+    { "sse2",   updateRowSSE2,   sse2Supported },
+#endif
+    { "scalar", updateRow,       scalarSupported }
+};
+const int NUM_KERNELS = sizeof(KERNELS) / sizeof(KERNELS[0]);
+
+/*****************************  validateKernel  *****************************
+ * int validateKernel(RowKernel kernel)
+ *
+ * Description: Checks kernel against updateRow on random rows.
+ *
+ * Process:
+ * 1.) Fill three rows with random values large enough to reach every
+ *     rule (sums from 0 to well over 150).
+ * 2.) Run both kernels and compare every column, including the
+ *     perimeter columns which must be left untouched.
+ * 3.) Repeat for a number of trials.
+ *
+ * Parameter    Direction   Description
+ * --------------------------------------------------------------------
+ * kernel       in          kernel to check
+ *
+ * NOTES:
+ * - Returns 1 if every trial matches, 0 otherwise.
+ * - Uses its own generator so the sequence of rand() used by
+ *   fillRandomly is not disturbed.
+ ***********************************************************************/
+int validateKernel(RowKernel kernel)
+{
+    int trial, j;
+    int rows[3][N];
+    int expected[N], actual[N];
+    unsigned int state = 12345;
+
+    for (trial = 0; trial < 64; trial++)
+    {
+        for (j = 0; j < 3 * N; j++)
+        {
+            state = state * 1103515245u + 12345u;
+            // alternate small and large ranges to hit all four rules
+            rows[j / N][j % N] = (state >> 16) % ((trial & 1) ? 60 : RANGE);
+        }
+        for (j = 0; j < N; j++)
+            expected[j] = actual[j] = -1;
+
+        updateRow(rows[0], rows[1], rows[2], expected);
+        kernel(rows[0], rows[1], rows[2], actual);
+        if (memcmp(expected, actual, sizeof(expected)) != 0)
+            return 0;
+    }
+    return 1;
+}
+
+/*****************************  selectKernel  *****************************
+ * int selectKernel(const char *name)
+ *
+ * Description: Sets ROW_KERNEL, see the selection rules at the top of
+ * this file.
+ *
+ * Parameter    Direction   Description
+ * --------------------------------------------------------------------
+ * name         in          kernel to force, or NULL to use T2_KERNEL or
+ *                          pick the fastest supported one
+ *
+ * NOTES:
+ * - Returns 0 on success.  A forced kernel that is unknown, unsupported
+ *   or fails validation is an error (GENERIC_ERROR_CODE) rather than a
+ *   silent fallback.
+ ***********************************************************************/
+int selectKernel(const char *name)
+{
+    int k;
+
+    if (name == NULL)
+        name = getenv("T2_KERNEL");
+
+    for (k = 0; k < NUM_KERNELS; k++)
+    {
+        if (name != NULL && strcmp(name, KERNELS[k].name) != 0)
+            continue;
+        if (!KERNELS[k].supported())
+        {
+            if (name != NULL)
+            {
+                fprintf(stderr, "kernel %s is not supported on this CPU\n", name);
+                return GENERIC_ERROR_CODE;
+            }
+            continue;
+        }
+        if (!validateKernel(KERNELS[k].run))
+        {
+            fprintf(stderr, "kernel %s disagrees with scalar reference\n",
+                    KERNELS[k].name);
+            if (name != NULL)
+                return GENERIC_ERROR_CODE;
+            continue;
+        }
+        ROW_KERNEL = KERNELS[k].run;
+        ROW_KERNEL_NAME = KERNELS[k].name;
+        return 0;
+    }
+
+    fprintf(stderr, "unknown kernel %s, choose from:", name);
+    for (k = 0; k < NUM_KERNELS; k++)
+        fprintf(stderr, " %s", KERNELS[k].name);
+    fprintf(stderr, "\n");
+    return GENERIC_ERROR_CODE;
+}
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 #include "define.h"
 /***********************************************************************
@@ -10,14 +11,38 @@
  *  generations.
  * -Array A is always printed out and contains the values of the most
  *  recent generation.  The array B is always used to compute the values.
+ * -Threads are created once and reused for every generation.
+ * -Daemon mode (-d socket) keeps the threads and grids warm and accepts
+ *  jobs over a Unix domain socket, see server.c.
+ * -Optional per-generation statistics (-s file) are accumulated inside
+ *  the update pass, see updateRowStats and stats.c.
+ * -In-place mode (-i) drops array B and updates A row by row, keeping
+ *  only a few saved rows per thread, see updateCellsInPlace.
+ * -Row kernels (scalar, SSE2, AVX2, AVX-512) are picked at startup from
+ *  what the CPU supports; -k name or T2_KERNEL=name forces one, see
+ *  kernels.c.
+ * -Thread count (-t) and partition granularity (-c) are runtime settings.
+ *  -a times candidates on the real grid and saves the winner to a
+ *  profile (-p, default ~/.t2_v3_profile) that later runs load, see
+ *  tune.c.
+ * -Grids come from an arena that uses 2MB pages when it can and reuses
+ *  released buffers; -m reports its footprint, see arena.c.
+ * -Printing runs on its own thread while the next generation is
+ *  computed, using three rotating grids, see pipeline.c.
  *
  * Description: Given an MxN matrix compute the
  * sums of each cell and its neighbors.  Use the sum
  * and the set of rules to derive the each cell's
  * new value.
  *
- * compile: %gcc main.c arrays.c -o t2_v3
+ * compile: %gcc main.c arrays.c server.c stats.c kernels.c tune.c arena.c
+ *          pipeline.c -o t2_v3 -lpthread
  * execute: ./t2_v3
+ *          ./t2_v3 -d /tmp/t2_v3.sock
+ *          ./t2_v3 -s stats.csv
+ *          ./t2_v3 -i
+ *          ./t2_v3 -k sse2
+ *          ./t2_v3 -a -p profile
  *
  * Process:
  * 1.) Compute a cell sum (based on its value and its
@@ -45,10 +70,34 @@
 // Global extern basis variables
 // Used to make working with threads easier since each thread shares
 // data which includes global variables
-int A[M][N] = {0};
-int B[M][N];
+// Both are allocated in main.  In in-place mode (-i) only A is
+// allocated and B points at it.
+int (*A)[N];
+int (*B)[N];
+int IN_PLACE = 0;
 int CURRENT_GENERATION = 0;
 
+// Per-generation statistics, only collected when STATS_OUT is set
+// Each thread accumulates into its own THREAD_STATS entry
+FILE *STATS_OUT = NULL;
+GenStats THREAD_STATS[MAX_THREADS];
+
+// Thread pool state, guarded by POOL_LOCK
+// POOL_TICKET is bumped once per generation to release the workers
+// THREAD_COUNT and CHUNK_ROWS may only change while the pool is down
+int THREAD_COUNT = NUM_THREADS;
+int CHUNK_ROWS = 0;             // 0 = one static strip per thread
+int NEXT_ROW = 0;               // next unclaimed row when CHUNK_ROWS > 0
+pthread_t WORKERS[MAX_THREADS];
+pthread_mutex_t POOL_LOCK = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t POOL_START = PTHREAD_COND_INITIALIZER;
+pthread_cond_t POOL_DONE = PTHREAD_COND_INITIALIZER;
+long POOL_TICKET = 0;
+int POOL_FINISHED = 0;
+int POOL_SAVED = 0;             // in-place mode: threads done saving edges
+pthread_cond_t POOL_EDGES_SAVED = PTHREAD_COND_INITIALIZER;
+int POOL_SHUTDOWN = 0;
+
 /*****************************  newValue  *****************************
  * int newValue(int sum, int cellValue)
  *
@@ -81,41 +130,54 @@ int CURRENT_GENERATION = 0;
  * Over  50		Subtract 3      Sums between 51 and 150 not divisible 
  *                              by 10
  * Over 150		1               Sums 151 and greater not divisible by 10
+ *
+ * newValueRule is the same function that also reports which rule
+ * fired (RULE_ZERO ... RULE_ONE), used when statistics are collected.
  ***********************************************************************/
-int newValue(int sum, int cellValue)
+static inline int newValueRule(int sum, int cellValue, int *rule)
 {
     int value = -9999;
-    if (sum % 10 == 0)               value = 0;
-    else if (sum < 50)               value = cellValue + 3;
-    else if (sum > 50 && sum < 150)  value = ((cellValue - 3) < 0) ? 0 : (cellValue - 3);
-    else                             value = 1;
+    if (sum % 10 == 0)               { value = 0;  *rule = RULE_ZERO; }
+    else if (sum < 50)               { value = cellValue + 3;  *rule = RULE_ADD; }
+    else if (sum > 50 && sum < 150)  { value = ((cellValue - 3) < 0) ? 0 : (cellValue - 3);  *rule = RULE_SUBTRACT; }
+    else                             { value = 1;  *rule = RULE_ONE; }
     
     return value;
 }
 
+int newValue(int sum, int cellValue)
+{
+    int rule;
+    return newValueRule(sum, cellValue, &rule);
+}
+
 /*****************************  computeSum  *****************************
- * int computeSum(int i, int j)
+ * int computeSum(const int *above, const int *row, const int *below, int j)
  *
- * Description: Takes a 2D array and computes sum of B[i][j] and
- * its neighbors.  Returns this value to the calling environment.
+ * Description: Computes the sum of row[j] and its neighbors, where
+ * above and below are the rows on either side of row.  Returns this
+ * value to the calling environment.
  *
  * Process:
- *     Assumption: no indices i or j are passed to this function
+ *     Assumption: no index j is passed to this function
  *     that will be out of bounds or not capable of being computed.
  * 1.) The values of neighbor cells are hardcoded and added together
- *     with B[i][j].
+ *     with row[j].
  * 2.) Sum is returned.
  *
  * Parameter    Direction   Description
  * --------------------------------------------------------------------
- * i            in          row of computed element
+ * above        in          previous generation's values of row i - 1
+ * row          in          previous generation's values of row i
+ * below        in          previous generation's values of row i + 1
  * j            in          column of computed element
  *
  * NOTES:
  * - Please see assumption under Process above.
- * - Uses globally defined array B.
+ * - Taking rows instead of B[i] lets the in-place mode pass saved
+ *   copies of rows that were already overwritten.
  *
- * Neighbor diagram (assume X is B[i][j]):
+ * Neighbor diagram (assume X is row[j]):
  *    Start here:  1 ->  2  -> 3
  *                             |
  *                             V
@@ -125,59 +187,180 @@ int newValue(int sum, int cellValue)
  *                 7 <-  6  <- 5
  * Neighbor order goes 1, 2, 3, 4, 5, 6, 7, 8, X
  ***********************************************************************/
-int computeSum(int i, int j)
+static inline int computeSum(const int *above, const int *row, const int *below, int j)
 {
     int sum = 0;
-    sum = B[i - 1][j - 1] +   // 1
-    B[i - 1][  j  ] +         // 2
-    B[i - 1][j + 1] +         // 3
-    B[  i  ][j + 1] +         // 4
-    B[i + 1][j + 1] +         // 5
-    B[i + 1][  j  ] +         // 6
-    B[i + 1][j - 1] +         // 7
-    B[  i  ][j - 1] +         // 8
-    B[  i  ][  j  ];          // X
+    sum = above[j - 1] +      // 1
+    above[  j  ] +            // 2
+    above[j + 1] +            // 3
+    row[j + 1] +              // 4
+    below[j + 1] +            // 5
+    below[  j  ] +            // 6
+    below[j - 1] +            // 7
+    row[j - 1] +              // 8
+    row[  j  ];               // X
     return sum;
 }
 
+/*****************************  updateRow  *****************************
+ * void updateRow(const int *above, const int *row, const int *below,
+ *                int *out)
+ *
+ * Description: Computes the new value of every interior cell of one
+ * row and stores it in out.
+ *
+ * Parameter    Direction   Description
+ * --------------------------------------------------------------------
+ * above        in          previous generation's values of row i - 1
+ * row          in          previous generation's values of row i
+ * below        in          previous generation's values of row i + 1
+ * out          out         new values of row i, columns 1 to N - 2
+ *
+ * NOTES:
+ * - out may not alias above, row or below.
+ * - This is the scalar reference kernel.  The update passes call
+ *   whichever kernel selectKernel put in ROW_KERNEL.
+ ***********************************************************************/
+void updateRow(const int *above, const int *row, const int *below, int *out)
+{
+    updateRowFrom(above, row, below, out, 1);
+}
+
+/*****************************  updateRowFrom  *****************************
+ * void updateRowFrom(const int *above, const int *row, const int *below,
+ *                    int *out, int first)
+ *
+ * Description: updateRow for columns first to N - 2 only.  The SIMD
+ * kernels in kernels.c use it for the columns after their last full
+ * vector.
+ ***********************************************************************/
+void updateRowFrom(const int *above, const int *row, const int *below, int *out, int first)
+{
+    int j;
+    for (j = first; j < N - 1; j++)
+        out[j] = newValue(computeSum(above, row, below, j), row[j]);
+}
+
+/***************************  updateRowStats  ***************************
+ * void updateRowStats(const int *above, const int *row, const int *below,
+ *                     int *out, GenStats *stats)
+ *
+ * Description: Same as updateRow, but also accumulates the statistics
+ * of the new values while they are still in registers, so collecting
+ * statistics costs no extra pass over A.
+ *
+ * Parameter    Direction   Description
+ * --------------------------------------------------------------------
+ * above        in          previous generation's values of row i - 1
+ * row          in          previous generation's values of row i
+ * below        in          previous generation's values of row i + 1
+ * out          out         new values of row i, columns 1 to N - 2
+ * stats        in/out      this thread's accumulator, added to
+ ***********************************************************************/
+void updateRowStats(const int *above, const int *row, const int *below,
+                    int *out, GenStats *stats)
+{
+    int j;
+    int value;
+    int rule;
+    int bin;
+    for (j = 1; j < N - 1; j++)
+    {
+        value = newValueRule(computeSum(above, row, below, j), row[j], &rule);
+        out[j] = value;
+        
+        bin = value / HIST_WIDTH;
+        if (bin >= HIST_BINS)
+            bin = HIST_BINS - 1;
+        stats->sum += value;
+        stats->zeros += (value == 0);
+        stats->hist[bin]++;
+        stats->rules[rule]++;
+    }
+}
+
 /*****************************  updateCells  *****************************
- * void updateCells(int start, int end)
+ * void updateCells(int start, int end, GenStats *stats)
  *
  * Description: Takes a 2D array and computes a new positive integer
  * value for each applicable cell based on a set of rules.  The new
  * value is stored in another array.
  *
  * Process:
- * 1.) For each cell in gloabl array B, call computeSum for indices
- *     i and j.
- * 2.) Sum is used with a set of conditions and rules to determine
- *     the new value of the cell in global array A.  A separate function 
- *     is called for this part, newValue(sum).
- * 3.) The new value is stored into global array A.
+ * 1.) For each row in global array B, call ROW_KERNEL (or updateRowStats)
+ *     with the rows around it.
+ * 2.) The kernel computes each cell's sum and uses newValue to determine
+ *     the new value.
+ * 3.) The new values are stored into global array A.
  *
  * Parameter    Direction   Description
  * --------------------------------------------------------------------
  * start        in          first row worked on
  * end          in          last row worked on
+ * stats        in/out      this thread's accumulator, NULL when
+ *                          statistics are not collected
  *
  * NOTES:
  * - The outer perimeter is not in play.  The outer perimeter of both
  *   arrays are 0's used to help programmer.
+ * - Statistics always use the scalar updateRowStats.
  ***********************************************************************/
-void updateCells(int start, int end)
+void updateCells(int start, int end, GenStats *stats)
 {
     int i;
-    int j;
-    int sum = 0;
     for (i = start; i < end; i++)
     {
-        for (j = 1; j < N - 1; j++)
-        {
-            // get sum of neighbors and current cell
-            sum = computeSum(i, j);
-            // store newValue based on rules into arr2
-            A[i][j] = newValue(sum, B[i][j]);
-        }
+        if (stats != NULL)
+            updateRowStats(B[i - 1], B[i], B[i + 1], A[i], stats);
+        else
+            ROW_KERNEL(B[i - 1], B[i], B[i + 1], A[i]);
+    }
+}
+
+/**************************  updateCellsInPlace  **************************
+ * void updateCellsInPlace(int start, int end, int *prev, int *cur,
+ *                         const int *below, GenStats *stats)
+ *
+ * Description: In-place version of updateCells.  Computes the next
+ * generation of rows start to end - 1 directly in A, keeping only a
+ * rolling copy of the previous generation's rows.
+ *
+ * Process:
+ * 1.) prev holds the old values of the row above the current row.
+ * 2.) Save the current row into cur, then overwrite it in A using prev,
+ *     cur and the row below (still old, or the saved edge row below the
+ *     strip for the last row).
+ * 3.) The saved current row becomes prev for the next row.
+ *
+ * Parameter    Direction   Description
+ * --------------------------------------------------------------------
+ * start        in          first row worked on
+ * end          in          last row worked on
+ * prev         in          old values of row start - 1, saved before any
+ *                          thread started writing; used as scratch
+ * cur          in          scratch row of N ints
+ * below        in          old values of row end, saved the same way
+ * stats        in/out      this thread's accumulator, or NULL
+ *
+ * NOTES:
+ * - Rows start - 1 and end belong to neighbor strips which may already
+ *   be updated, so they must only be read through prev and below.
+ ***********************************************************************/
+void updateCellsInPlace(int start, int end, int *prev, int *cur,
+                        const int *below, GenStats *stats)
+{
+    int i;
+    int *swap;
+    for (i = start; i < end; i++)
+    {
+        memcpy(cur, A[i], sizeof(A[i]));
+        if (stats != NULL)
+            updateRowStats(prev, cur, (i + 1 == end) ? below : A[i + 1], A[i], stats);
+        else
+            ROW_KERNEL(prev, cur, (i + 1 == end) ? below : A[i + 1], A[i]);
+        swap = prev;
+        prev = cur;
+        cur = swap;
     }
 }
 
@@ -186,12 +369,17 @@ void updateCells(int start, int end)
  *
  * Description: The entry point for each pthread in program. Uses static
  * work partition algorithm to assign jobs to each thread based on their
- * tid. Jobs are the number of rows a thread will work on.
+ * tid. Jobs are the number of rows a thread will work on.  When
+ * CHUNK_ROWS is set, threads instead keep claiming the next CHUNK_ROWS
+ * rows until none are left.
  *
  * Process:
  * 1.) Determine how many rows each thread is responsible for.
- * 2.) Call updateCells
- * 3.) Thread exits
+ * 2.) Wait until computeGeneration hands out a new generation.
+ * 3.) Call updateCells and report back as finished.  In in-place mode,
+ *     first save the rows bordering the strip and wait until every
+ *     thread has done so, then call updateCellsInPlace.
+ * 4.) Repeat from 2 until spinDownThreads asks the pool to exit.
  *
  * Parameter    Direction   Description
  * --------------------------------------------------------------------
@@ -200,20 +388,28 @@ void updateCells(int start, int end)
  *
  * NOTES:
  * - Built to be flexible for changing values of M (number of rows) and
- *   NUM_THREADS, defined constants.
+ *   THREAD_COUNT.
+ * - In-place mode always uses static strips, since each strip saves
+ *   the rows around it before the update.
+ * - Threads stay alive between generations (and between daemon jobs),
+ *   so thread creation is paid for once per process.
  **************************************************************************/
 void *entryPoint(void *param)
 {
-    int i;
-    int tid = (int) param;
+    int tid = (int) (long) param;
     int rows = M - 2;   // first and last row don't count
-    int numRows = rows / NUM_THREADS;
-    int remainingRows = rows % NUM_THREADS;
+    int numRows = rows / THREAD_COUNT;
+    int remainingRows = rows % THREAD_COUNT;
     int startRow = numRows * tid;
     int endRow;
-    // last thread is one less than NUM_THREADS
+    int first;
+    long seen = 0;
+    GenStats *stats;
+    // rolling rows for the in-place mode
+    int prev[N], cur[N], below[N];
+    // last thread is one less than THREAD_COUNT
     // last thread is assigned remaining number of rows
-    if (tid == NUM_THREADS - 1)
+    if (tid == THREAD_COUNT - 1)
     {
         endRow = numRows * tid + numRows + remainingRows;
     }
@@ -222,59 +418,349 @@ void *entryPoint(void *param)
         endRow = numRows * tid + numRows;
     }
     
-    for (i = startRow; i < endRow; i++)
-        updateCells(startRow + 1, endRow + 1);
+    for (;;)
+    {
+        pthread_mutex_lock(&POOL_LOCK);
+        while (POOL_TICKET == seen && !POOL_SHUTDOWN)
+            pthread_cond_wait(&POOL_START, &POOL_LOCK);
+        if (POOL_SHUTDOWN)
+        {
+            pthread_mutex_unlock(&POOL_LOCK);
+            break;
+        }
+        seen = POOL_TICKET;
+        pthread_mutex_unlock(&POOL_LOCK);
+        
+        stats = NULL;
+        if (STATS_OUT != NULL)
+        {
+            stats = &THREAD_STATS[tid];
+            clearStats(stats);
+        }
+        
+        if (IN_PLACE)
+        {
+            // save the rows around the strip before anyone overwrites them
+            if (startRow < endRow)
+            {
+                memcpy(prev, A[startRow], sizeof(prev));
+                memcpy(below, A[endRow + 1], sizeof(below));
+            }
+            pthread_mutex_lock(&POOL_LOCK);
+            if (++POOL_SAVED == THREAD_COUNT)
+                pthread_cond_broadcast(&POOL_EDGES_SAVED);
+            while (POOL_SAVED < THREAD_COUNT)
+                pthread_cond_wait(&POOL_EDGES_SAVED, &POOL_LOCK);
+            pthread_mutex_unlock(&POOL_LOCK);
+            
+            if (startRow < endRow)
+                updateCellsInPlace(startRow + 1, endRow + 1, prev, cur, below, stats);
+        }
+        else if (CHUNK_ROWS > 0)
+        {
+            while ((first = __atomic_fetch_add(&NEXT_ROW, CHUNK_ROWS, __ATOMIC_RELAXED)) < rows)
+                updateCells(first + 1, ((first + CHUNK_ROWS < rows) ? first + CHUNK_ROWS : rows) + 1, stats);
+        }
+        else if (startRow < endRow)
+        {
+            updateCells(startRow + 1, endRow + 1, stats);
+        }
+        
+        pthread_mutex_lock(&POOL_LOCK);
+        if (++POOL_FINISHED == THREAD_COUNT)
+            pthread_cond_signal(&POOL_DONE);
+        pthread_mutex_unlock(&POOL_LOCK);
+    }
     
     pthread_exit(NULL);
 }
 
 /*****************************  spinUpThreads  *****************************
- * void spinUpThreads()
+ * void spinUpThreads(void)
  *
- * Description: Sets up threads to work on 2D array.
+ * Description: Sets up the pool of threads that work on the 2D array.
  *
  * Process:
- * 1.) Create NUM_THREADS (defined constant) and start them off at entryPoint.
+ * 1.) Create THREAD_COUNT threads and start them off at entryPoint.
  *     entryPoint is a function which will provide the thread with tasks.
- * 2.) Join threads upon their exit.
- * 3.) Return to main function.
+ * 2.) Return to main function, threads wait for computeGeneration.
  *
  * Parameter    Direction   Description
  * --------------------------------------------------------------------
  * None
  *
  * NOTES:
- * - N/A
+ * - Pair with spinDownThreads.  The pool may be started again after
+ *   spinDownThreads, e.g. to change THREAD_COUNT (see tune.c), but
+ *   never while it is already running.
  ***********************************************************************/
-void spinUpThreads()
+void spinUpThreads(void)
+{
+    long t;
+    
+    POOL_TICKET = 0;
+    POOL_SHUTDOWN = 0;
+    for (t = 0; t < THREAD_COUNT; t++)
+        pthread_create(&WORKERS[t], NULL, entryPoint, (void *) t);
+}
+
+/***************************  computeGeneration  ***************************
+ * void computeGeneration(void)
+ *
+ * Description: Computes one generation (B -> A) with the thread pool.
+ * In in-place mode A and B are the same grid.
+ *
+ * Process:
+ * 1.) Hand out a new ticket and wake every worker.
+ * 2.) Wait until all THREAD_COUNT workers report their rows finished.
+ *
+ * Parameter    Direction   Description
+ * --------------------------------------------------------------------
+ * None
+ ***********************************************************************/
+void computeGeneration(void)
+{
+    pthread_mutex_lock(&POOL_LOCK);
+    POOL_FINISHED = 0;
+    POOL_SAVED = 0;
+    NEXT_ROW = 0;
+    POOL_TICKET++;
+    pthread_cond_broadcast(&POOL_START);
+    while (POOL_FINISHED < THREAD_COUNT)
+        pthread_cond_wait(&POOL_DONE, &POOL_LOCK);
+    pthread_mutex_unlock(&POOL_LOCK);
+}
+
+/****************************  spinDownThreads  ****************************
+ * void spinDownThreads(void)
+ *
+ * Description: Asks every pooled thread to exit and joins them.
+ *
+ * Parameter    Direction   Description
+ * --------------------------------------------------------------------
+ * None
+ ***********************************************************************/
+void spinDownThreads(void)
 {
-    pthread_t tid[NUM_THREADS];
     long t;
     void *status;
     
-    for (t = 0; t < NUM_THREADS; t++)
-        pthread_create(&tid[t], NULL, entryPoint, (void *) t);
+    pthread_mutex_lock(&POOL_LOCK);
+    POOL_SHUTDOWN = 1;
+    pthread_cond_broadcast(&POOL_START);
+    pthread_mutex_unlock(&POOL_LOCK);
     
-    for (t = 0; t < NUM_THREADS; t++)
-        pthread_join(tid[t], &status);
+    for (t = 0; t < THREAD_COUNT; t++)
+        pthread_join(WORKERS[t], &status);
+}
+
+/**************************  writeGenerationStats  **************************
+ * void writeGenerationStats(void)
+ *
+ * Description: If statistics are on, reduces the per-thread
+ * accumulators of the generation just computed and writes its row.
+ *
+ * NOTES:
+ * - Only call between computeGeneration calls, while workers are idle.
+ ***********************************************************************/
+void writeGenerationStats(void)
+{
+    int t;
+    GenStats total;
+    
+    if (STATS_OUT == NULL)
+        return;
+    // workers are idle again, their accumulators are safe to read
+    clearStats(&total);
+    for (t = 0; t < THREAD_COUNT; t++)
+        addStats(&total, &THREAD_STATS[t]);
+    writeStatsRow(STATS_OUT, CURRENT_GENERATION, &total);
+}
+
+/*******************************  simulate  *******************************
+ * void simulate(int generations, FILE *out)
+ *
+ * Description: Runs the requested number of generations starting from
+ * the values in B.  Afterwards A and B both hold the last generation.
+ *
+ * Parameter    Direction   Description
+ * --------------------------------------------------------------------
+ * generations  in          number of generations to compute
+ * out          in          stream receiving every generation, or NULL
+ *                          when only the final values are wanted
+ *
+ * NOTES:
+ * - Requires spinUpThreads to have been called.
+ * - When STATS_OUT is set, one statistics row per generation is
+ *   written to it.
+ * - With out set (and two grids), the work is handed to
+ *   simulatePipelined, which prints generation g while generation
+ *   g + 1 is computed.
+ ***********************************************************************/
+void simulate(int generations, FILE *out)
+{
+    // printing can overlap computing when there are two grids to rotate
+    if (out != NULL && !IN_PLACE && simulatePipelined(generations, out) == 0)
+        return;
+    
+    CURRENT_GENERATION = 0;
+    // Array A always contains current values, array B is used for intermediate results
+    while (CURRENT_GENERATION < generations)
+    {
+        computeGeneration();
+        writeGenerationStats();
+        if (out != NULL)
+        {
+            fprintf(out, "Gen:  %d ---------------------------  \n", CURRENT_GENERATION);
+            fprintArray(out, M, N, A);
+        }
+        if (B != A)
+            copyArray(M, N, A, B);  // copy values from A into B
+        CURRENT_GENERATION++;
+    }
+}
+
+/*******************************  freeGrids  *******************************
+ * void freeGrids(void)
+ *
+ * Description: Releases A and B (only A in in-place mode).
+ ***********************************************************************/
+void freeGrids(void)
+{
+    if (B != A)
+        arenaRelease(B);
+    arenaRelease(A);
+    A = NULL;
+    B = NULL;
 }
 
 int main(int argc, const char * argv[])
 {
+    int i;
+    int status = 0;
+    const char *socketPath = NULL;
+    const char *statsPath = NULL;
+    const char *kernelName = NULL;
+    const char *profilePath = NULL;
+    char defaultProfile[MAX_PATH_LEN];
+    int tune = 0;
+    int threads = 0;
+    int chunk = -1;
+    int profileLoaded = 0;
+    int memoryReport = 0;
+    char report[MAX_LINE];
+    
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+            socketPath = argv[++i];
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            statsPath = argv[++i];
+        else if (strcmp(argv[i], "-i") == 0)
+            IN_PLACE = 1;
+        else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc)
+            kernelName = argv[++i];
+        else if (strcmp(argv[i], "-a") == 0)
+            tune = 1;
+        else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+            profilePath = argv[++i];
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+            chunk = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-m") == 0)
+            memoryReport = 1;
+        else
+        {
+            threads = -1;
+            break;
+        }
+    }
+    if (threads < 0 || threads > MAX_THREADS || (chunk < -1))
+    {
+        fprintf(stderr, "usage: %s [-d socket] [-s stats.csv] [-i] [-k kernel]\n"
+                "          [-a] [-p profile] [-t threads (1-%d)] [-c chunk rows] [-m]\n",
+                argv[0], MAX_THREADS);
+        return GENERIC_ERROR_CODE;
+    }
+    
+    if (profilePath == NULL)
+    {
+        snprintf(defaultProfile, sizeof(defaultProfile), "%s/%s",
+                 getenv("HOME") ? getenv("HOME") : ".", PROFILE_NAME);
+        profilePath = defaultProfile;
+    }
+    
+    // a saved profile replaces the defaults, options given here win over it
+    if (!tune)
+        profileLoaded = (loadProfile(profilePath) == 0);
+    if (!profileLoaded || kernelName != NULL || getenv("T2_KERNEL") != NULL)
+        if (selectKernel(kernelName) != 0)
+            return GENERIC_ERROR_CODE;
+    if (threads > 0)
+        THREAD_COUNT = threads;
+    if (chunk >= 0)
+        CHUNK_ROWS = chunk;
+    
+    // arena buffers start zeroed, which leaves the perimeter of A at 0
+    A = arenaAcquire(M * sizeof(*A));
+    B = IN_PLACE ? A : arenaAcquire(M * sizeof(*B));
+    if (A == NULL || B == NULL)
+    {
+        fprintf(stderr, "out of memory for %d x %d grid\n", M, N);
+        return GENERIC_ERROR_CODE;
+    }
     fillRandomly(M, N, B);
+    
+    // -a tunes on the grid just filled, which is restored afterwards
+    if (tune)
+    {
+        autotune(kernelName == NULL && getenv("T2_KERNEL") == NULL,
+                 threads == 0, chunk < 0);
+        if (saveProfile(profilePath) != 0)
+            fprintf(stderr, "can't write profile %s\n", profilePath);
+    }
+    
+    // -d <socket> runs as a daemon accepting jobs, see server.c
+    if (socketPath != NULL)
+    {
+        spinUpThreads();
+        status = runServer(socketPath);
+        spinDownThreads();
+        freeGrids();
+        arenaDestroy();
+        return status;
+    }
+    
+    // -s <file> writes a CSV row of statistics per generation, see stats.c
+    if (statsPath != NULL)
+    {
+        STATS_OUT = fopen(statsPath, "w");
+        if (STATS_OUT == NULL)
+        {
+            perror(statsPath);
+            return ERROR_FILE;
+        }
+        writeStatsHeader(STATS_OUT);
+    }
+    
     // Print out values returned by random filling function
     printf("Initial Values ---------------------------  \n");
     print(M, N, B);
     
-    // Array A always contains current values, array B is used for intermediate results
-    while (CURRENT_GENERATION < TOTAL_GENERATIONS)
+    spinUpThreads();
+    simulate(TOTAL_GENERATIONS, stdout);
+    spinDownThreads();
+    
+    if (STATS_OUT != NULL)
+        fclose(STATS_OUT);
+    // -m reports grid memory (arena.c) on stderr
+    if (memoryReport)
     {
-        spinUpThreads();
-        printf("Gen:  %d ---------------------------  \n", CURRENT_GENERATION);
-        print(M, N, A);
-        copyArray(M, N, A, B);  // copy values from A into B
-        CURRENT_GENERATION++;
+        arenaReport(report, sizeof(report));
+        fprintf(stderr, "%s\n", report);
     }
-    
-    return 0;
+    freeGrids();
+    arenaDestroy();
+    return status;
 }
@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "define.h"
+/***********************************************************************
+ * pipeline.c written by DSU_410 team ...
+ *
+ * Description: Overlaps computing with printing.  Instead of compute,
+ * print, copy for every generation, PIPELINE_DEPTH grids rotate:
+ * generation g reads grid g % 3 and writes grid (g + 1) % 3, while a
+ * printer thread prints earlier generations from the grids they were
+ * written to.  Run time is about the larger of compute and output
+ * rather than their sum, and the copy from A back into B goes away.
+ *
+ *   grid:      0         1         2         0   ...
+ *   holds:   start  -> gen 0  -> gen 1  -> gen 2 ...
+ *
+ * Backpressure: generation g overwrites the grid holding generation
+ * g - 3, so computing waits until the printer is done with it.  The
+ * printer can fall at most PIPELINE_DEPTH - 1 generations behind.
+ ***********************************************************************/
+
+// Pipeline state, guarded by PIPE_LOCK
+static pthread_mutex_t PIPE_LOCK = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t PIPE_COMPUTED = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t PIPE_PRINTED_COND = PTHREAD_COND_INITIALIZER;
+static int PIPE_READY = 0;      // generations computed
+static int PIPE_PRINTED = 0;    // generations printed
+static int PIPE_TOTAL = 0;
+static FILE *PIPE_OUT = NULL;
+static int (*PIPE_GRIDS[PIPELINE_DEPTH])[N];
+
+/*****************************  printer  *****************************
+ * void *printer(void *param)
+ *
+ * Description: Printer thread.  Prints each generation as soon as it
+ * is computed, then tells the producer its grid is free again.
+ *
+ * Parameter    Direction   Description
+ * --------------------------------------------------------------------
+ * param        in          unused
+ ***********************************************************************/
+static void *printer(void *param)
+{
+    int g;
+    (void) param;
+
+    for (g = 0; g < PIPE_TOTAL; g++)
+    {
+        pthread_mutex_lock(&PIPE_LOCK);
+        while (PIPE_READY <= g)
+            pthread_cond_wait(&PIPE_COMPUTED, &PIPE_LOCK);
+        pthread_mutex_unlock(&PIPE_LOCK);
+
+        fprintf(PIPE_OUT, "Gen:  %d ---------------------------  \n", g);
+        fprintArray(PIPE_OUT, M, N, PIPE_GRIDS[(g + 1) % PIPELINE_DEPTH]);
+
+        pthread_mutex_lock(&PIPE_LOCK);
+        PIPE_PRINTED = g + 1;
+        pthread_cond_signal(&PIPE_PRINTED_COND);
+        pthread_mutex_unlock(&PIPE_LOCK);
+    }
+    pthread_exit(NULL);
+}
+
+/**************************  simulatePipelined  **************************
+ * int simulatePipelined(int generations, FILE *out)
+ *
+ * Description: simulate for the two grid mode with output, computing
+ * generation g + 1 while generation g is printed.
+ *
+ * Process:
+ * 1.) Take a third grid from the arena; B and A are the other two.
+ * 2.) Start the printer thread.
+ * 3.) For each generation, wait until its target grid has been
+ *     printed, point B and A at the source and target grids, compute,
+ *     and wake the printer.
+ * 4.) Join the printer, then leave the last generation in the
+ *     original A and B, as simulate does.
+ *
+ * Parameter    Direction   Description
+ * --------------------------------------------------------------------
+ * generations  in          number of generations to compute
+ * out          in          stream receiving every generation
+ *
+ * NOTES:
+ * - Returns 0 when done, GENERIC_ERROR_CODE if the third grid or the
+ *   printer thread can't be had (nothing has run yet, so the caller
+ *   falls back to the sequential loop).
+ * - Requires spinUpThreads to have been called.  Workers read the
+ *   globals A and B after being released by computeGeneration, so
+ *   repointing them between generations is safe.
+ * - The start grid's perimeter is cleared after generation 0, matching
+ *   the sequential loop, where copying A into B clears it.
+ ***********************************************************************/
+int simulatePipelined(int generations, FILE *out)
+{
+    int g;
+    int (*first)[N] = B;
+    int (*second)[N] = A;
+    int (*third)[N];
+    int (*last)[N];
+    pthread_t thread;
+
+    if (generations <= 0)
+        return 0;
+    third = arenaAcquire(M * sizeof(*third));
+    if (third == NULL)
+        return GENERIC_ERROR_CODE;
+
+    PIPE_GRIDS[0] = first;
+    PIPE_GRIDS[1] = second;
+    PIPE_GRIDS[2] = third;
+    PIPE_READY = 0;
+    PIPE_PRINTED = 0;
+    PIPE_TOTAL = generations;
+    PIPE_OUT = out;
+    if (pthread_create(&thread, NULL, printer, NULL) != 0)
+    {
+        arenaRelease(third);
+        return GENERIC_ERROR_CODE;
+    }
+
+    for (g = 0; g < generations; g++)
+    {
+        // the target grid last held generation g - 3
+        pthread_mutex_lock(&PIPE_LOCK);
+        while (PIPE_PRINTED < g - (PIPELINE_DEPTH - 1))
+            pthread_cond_wait(&PIPE_PRINTED_COND, &PIPE_LOCK);
+        pthread_mutex_unlock(&PIPE_LOCK);
+
+        B = PIPE_GRIDS[g % PIPELINE_DEPTH];
+        A = PIPE_GRIDS[(g + 1) % PIPELINE_DEPTH];
+        CURRENT_GENERATION = g;
+        computeGeneration();
+        writeGenerationStats();
+        if (g == 0)
+            clearPerimeter(M, N, first);
+
+        pthread_mutex_lock(&PIPE_LOCK);
+        PIPE_READY = g + 1;
+        pthread_cond_signal(&PIPE_COMPUTED);
+        pthread_mutex_unlock(&PIPE_LOCK);
+    }
+    pthread_join(thread, NULL);
+
+    last = PIPE_GRIDS[generations % PIPELINE_DEPTH];
+    B = first;
+    A = second;
+    if (last != A)
+        copyArray(M, N, last, A);
+    if (last != B)
+        copyArray(M, N, last, B);
+    CURRENT_GENERATION = generations;
+    arenaRelease(third);
+    return 0;
+}
@@ -0,0 +1,671 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "define.h"
+/***********************************************************************
+ * server.c written by DSU_410 team ...
+ *
+ * Description: Daemon mode.  Keeps the thread pool and the global
+ * arrays A and B alive and runs jobs sent over a Unix domain socket,
+ * so small jobs don't pay for process start and thread creation.
+ *
+ * Protocol (one request per line, a client may send many at once):
+ *   RUN <rows> <cols> <seed|@snapshot> <generations> [outfile|@snapshot]
+ *       rows and cols must equal M and N.  A seed refills the grid
+ *       with fillRandomly, @path loads a saveSnapshot file instead.
+ *       Without outfile the reply is
+ *           OK <job> <generations> <service_us>
+ *       followed by <rows> lines of the final values and a "." line.
+ *       With outfile every generation is printed to that file; with
+ *       @path the final values are written with saveSnapshot, so a
+ *       later RUN can continue from them.  Either way the reply is the
+ *       OK line with the output name appended.
+ *   STATS     queue depth and service time, answered immediately,
+ *             even while a job runs
+ *   MEMORY    grid arena footprint and page backing, see arena.c
+ *   SHUTDOWN  daemon exits once every queued job has run
+ * Failures are answered with "ERR <reason>".
+ *
+ * Scheduling:
+ * -RUN requests are queued per client.  The daemon takes one job at a
+ *  time, going round-robin over clients with queued work, so a client
+ *  sending a large batch can't starve the others.
+ * -Jobs share A and B, so they run one after another, each using the
+ *  whole thread pool, and every job reuses the same grid buffers.
+ * -Jobs run on a separate runner thread, so the poll loop keeps
+ *  accepting connections and answering STATS, MEMORY and SHUTDOWN
+ *  while a job computes.
+ ***********************************************************************/
+
+typedef struct
+{
+    long id;
+    int useSnapshot;
+    unsigned int seed;
+    char snapshot[MAX_PATH_LEN];
+    int generations;
+    char outfile[MAX_PATH_LEN];  // starts with '@' for a snapshot
+    long long queuedAt;         // nowMicros when queued
+} Job;
+
+typedef struct
+{
+    int fd;                     // -1 when the slot is free
+    long serial;                // tells apart connections reusing a slot
+    char buf[MAX_LINE];
+    int len;
+    Job queue[MAX_QUEUED_JOBS];
+    int head;
+    int count;
+} Client;
+
+typedef struct
+{
+    long jobs;                  // jobs finished
+    long rejected;              // requests answered with ERR
+    int queued;                 // jobs waiting right now
+    int peakQueued;
+    long long totalService;     // microseconds spent running jobs
+    long long maxService;
+    long long totalWait;        // microseconds jobs sat in a queue
+} ServerStats;
+
+typedef struct
+{
+    Job job;
+    int client;                 // CLIENTS index the reply goes to
+    long serial;                // that client's serial when the job started
+    int ok;                     // 0 if the job was answered with ERR
+    long long start;            // nowMicros when the job started
+    long long service;
+    char *reply;                // malloc'd reply text, NULL if out of memory
+    size_t length;
+} Running;
+
+#define RUN_IDLE    0
+#define RUN_PENDING 1           // handed to the runner, not finished
+#define RUN_DONE    2           // finished, reply not collected yet
+
+static Client CLIENTS[MAX_CLIENTS];
+static ServerStats STATS;
+static long NEXT_JOB_ID = 1;
+static long NEXT_SERIAL = 1;
+static int SHUTDOWN_REQUESTED = 0;
+
+// Hand-off between the poll loop and the runner thread
+static pthread_mutex_t RUN_LOCK = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t RUN_READY = PTHREAD_COND_INITIALIZER;
+static int RUN_STATE = RUN_IDLE;
+static int RUNNER_EXIT = 0;
+static Running CURRENT;
+static int WAKE_PIPE[2] = {-1, -1};  // runner writes a byte when done
+
+/*****************************  nowMicros  *****************************
+ * long long nowMicros(void)
+ *
+ * Description: Monotonic clock reading in microseconds, used for
+ * timing jobs.
+ ***********************************************************************/
+long long nowMicros(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+/*****************************  dropClient  *****************************
+ * void dropClient(Client *c)
+ *
+ * Description: Closes a connection and forgets its queued jobs.
+ ***********************************************************************/
+static void dropClient(Client *c)
+{
+    close(c->fd);
+    STATS.queued -= c->count;
+    c->fd = -1;
+    c->len = 0;
+    c->head = 0;
+    c->count = 0;
+}
+
+/*****************************  parseRun  *****************************
+ * int parseRun(const char *line, Job *job, char *reason, int size)
+ *
+ * Description: Parses the arguments of a RUN request into job.
+ *
+ * Parameter    Direction   Description
+ * --------------------------------------------------------------------
+ * line         in          request line without the trailing newline
+ * job          out         filled in on success
+ * reason       out         explanation when the request is rejected
+ * size         in          size of reason
+ *
+ * NOTES:
+ * - Returns 0 on success, ERROR_DIMENSION_SIZE when rows/cols don't
+ *   match the compiled M and N, GENERIC_ERROR_CODE otherwise.
+ ***********************************************************************/
+static int parseRun(const char *line, Job *job, char *reason, int size)
+{
+    int rows, cols, fields;
+    char source[MAX_PATH_LEN];
+
+    memset(job, 0, sizeof(*job));
+    // %255s matches MAX_PATH_LEN
+    fields = sscanf(line, "RUN %d %d %255s %d %255s",
+                    &rows, &cols, source, &job->generations, job->outfile);
+    if (fields < 4)
+    {
+        snprintf(reason, size, "usage: RUN rows cols seed|@snapshot generations [outfile]");
+        return GENERIC_ERROR_CODE;
+    }
+    if (rows != M || cols != N)
+    {
+        snprintf(reason, size, "grid is compiled as %d x %d", M, N);
+        return ERROR_DIMENSION_SIZE;
+    }
+    if (job->generations < 0)
+    {
+        snprintf(reason, size, "generations must not be negative");
+        return GENERIC_ERROR_CODE;
+    }
+
+    if (source[0] == '@')
+    {
+        job->useSnapshot = 1;
+        strcpy(job->snapshot, source + 1);
+    }
+    else
+    {
+        job->seed = (unsigned int) strtoul(source, NULL, 10);
+    }
+    return 0;
+}
+
+/*****************************  handleLine  *****************************
+ * void handleLine(Client *c, char *line)
+ *
+ * Description: Acts on one request line.  RUN requests are queued,
+ * STATS, MEMORY and SHUTDOWN are answered right away.
+ ***********************************************************************/
+static void handleLine(Client *c, char *line)
+{
+    char reason[MAX_LINE];       // also holds the MEMORY report
+    Job *job;
+
+    if (strncmp(line, "RUN", 3) == 0)
+    {
+        if (c->count == MAX_QUEUED_JOBS)
+        {
+            dprintf(c->fd, "ERR queue full\n");
+            STATS.rejected++;
+            return;
+        }
+        job = &c->queue[(c->head + c->count) % MAX_QUEUED_JOBS];
+        if (parseRun(line, job, reason, sizeof(reason)) != 0)
+        {
+            dprintf(c->fd, "ERR %s\n", reason);
+            STATS.rejected++;
+            return;
+        }
+        job->id = NEXT_JOB_ID++;
+        job->queuedAt = nowMicros();
+        c->count++;
+        if (++STATS.queued > STATS.peakQueued)
+            STATS.peakQueued = STATS.queued;
+    }
+    else if (strcmp(line, "STATS") == 0)
+    {
+        dprintf(c->fd, "STATS queued %d peak_queued %d jobs %ld rejected %ld "
+                "avg_service_us %lld max_service_us %lld avg_wait_us %lld kernel %s\n",
+                STATS.queued, STATS.peakQueued, STATS.jobs, STATS.rejected,
+                STATS.jobs ? STATS.totalService / STATS.jobs : 0,
+                STATS.maxService,
+                STATS.jobs ? STATS.totalWait / STATS.jobs : 0,
+                ROW_KERNEL_NAME);
+    }
+    else if (strcmp(line, "MEMORY") == 0)
+    {
+        arenaReport(reason, sizeof(reason));
+        dprintf(c->fd, "MEMORY %s\n", reason);
+    }
+    else if (strcmp(line, "SHUTDOWN") == 0)
+    {
+        dprintf(c->fd, "OK shutting down\n");
+        SHUTDOWN_REQUESTED = 1;
+    }
+    else if (line[0] != '\0')
+    {
+        dprintf(c->fd, "ERR unknown request\n");
+        STATS.rejected++;
+    }
+}
+
+/*****************************  readClient  *****************************
+ * void readClient(Client *c)
+ *
+ * Description: Reads whatever the client has sent and hands every
+ * complete line to handleLine.  Partial lines wait for the next read.
+ ***********************************************************************/
+static void readClient(Client *c)
+{
+    char *start, *newline;
+    ssize_t got = read(c->fd, c->buf + c->len, sizeof(c->buf) - 1 - c->len);
+
+    if (got <= 0)
+    {
+        dropClient(c);
+        return;
+    }
+    c->len += (int) got;
+    c->buf[c->len] = '\0';
+
+    start = c->buf;
+    while ((newline = strchr(start, '\n')) != NULL)
+    {
+        *newline = '\0';
+        if (newline > start && newline[-1] == '\r')
+            newline[-1] = '\0';
+        handleLine(c, start);
+        start = newline + 1;
+    }
+    c->len -= (int) (start - c->buf);
+    memmove(c->buf, start, c->len);
+
+    // a full buffer without a newline can never become a valid request
+    if (c->len == (int) sizeof(c->buf) - 1)
+    {
+        dprintf(c->fd, "ERR line too long\n");
+        dropClient(c);
+    }
+}
+
+/*****************************  sendAll  *****************************
+ * void sendAll(int fd, const char *buf, size_t length)
+ *
+ * Description: Writes length bytes of buf to fd, retrying short
+ * writes.  Gives up quietly if the client has gone away.
+ ***********************************************************************/
+static void sendAll(int fd, const char *buf, size_t length)
+{
+    ssize_t sent;
+    while (length > 0)
+    {
+        sent = write(fd, buf, length);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            return;
+        buf += sent;
+        length -= (size_t) sent;
+    }
+}
+
+/*****************************  runJob  *****************************
+ * void runJob(Running *r)
+ *
+ * Description: Loads the starting grid for r->job, runs it on the
+ * thread pool and formats the reply into r->reply.
+ *
+ * NOTES:
+ * - Runs on the runner thread and touches nothing the poll loop owns;
+ *   runServer sends the reply and updates STATS.
+ ***********************************************************************/
+static void runJob(Running *r)
+{
+    int i, j;
+    int status;
+    Job *job = &r->job;
+    FILE *out = NULL;
+    FILE *reply;
+
+    r->start = nowMicros();
+    r->service = 0;
+    r->ok = 0;
+    r->reply = NULL;
+    r->length = 0;
+    reply = open_memstream(&r->reply, &r->length);
+    if (reply == NULL)
+        return;
+
+    if (job->useSnapshot)
+    {
+        status = loadSnapshot(job->snapshot, M, N, B);
+        if (status != 0)
+        {
+            fprintf(reply, "ERR %s snapshot %s\n",
+                    status == ERROR_DIMENSION_SIZE ? "wrong size" : "can't read",
+                    job->snapshot);
+            fclose(reply);
+            return;
+        }
+    }
+    else
+    {
+        srand(job->seed);
+        fillRandomly(M, N, B);
+    }
+
+    if (job->outfile[0] != '\0' && job->outfile[0] != '@')
+    {
+        out = fopen(job->outfile, "w");
+        if (out == NULL)
+        {
+            fprintf(reply, "ERR can't write %s\n", job->outfile);
+            fclose(reply);
+            return;
+        }
+        fprintf(out, "Initial Values ---------------------------  \n");
+        fprintArray(out, M, N, B);
+    }
+
+    simulate(job->generations, out);
+
+    if (out != NULL)
+        fclose(out);
+    // B holds the last generation (or the start grid for 0 generations)
+    if (job->outfile[0] == '@' && saveSnapshot(job->outfile + 1, M, N, B) != 0)
+    {
+        fprintf(reply, "ERR can't write snapshot %s\n", job->outfile + 1);
+        fclose(reply);
+        return;
+    }
+    r->service = nowMicros() - r->start;
+    r->ok = 1;
+
+    if (job->outfile[0] != '\0')
+    {
+        fprintf(reply, "OK %ld %d %lld %s\n", job->id, job->generations,
+                r->service, job->outfile);
+        fclose(reply);
+        return;
+    }
+
+    // the whole reply is formatted first so it goes out in one write
+    fprintf(reply, "OK %ld %d %lld\n", job->id, job->generations, r->service);
+    for (i = 0; i < M; i++)
+    {
+        for (j = 0; j < N; j++)
+            fprintf(reply, "%d ", B[i][j]);
+        fprintf(reply, "\n");
+    }
+    fprintf(reply, ".\n");
+    fclose(reply);
+}
+
+/*****************************  runnerMain  *****************************
+ * void *runnerMain(void *unused)
+ *
+ * Description: Runner thread.  Waits for runServer to hand over a job
+ * in CURRENT, runs it, and wakes the poll loop through WAKE_PIPE.
+ * Exits once RUNNER_EXIT is set and no job is pending.
+ ***********************************************************************/
+static void *runnerMain(void *unused)
+{
+    (void) unused;
+    pthread_mutex_lock(&RUN_LOCK);
+    while (1)
+    {
+        while (RUN_STATE != RUN_PENDING && !RUNNER_EXIT)
+            pthread_cond_wait(&RUN_READY, &RUN_LOCK);
+        if (RUN_STATE != RUN_PENDING)
+            break;
+        pthread_mutex_unlock(&RUN_LOCK);
+
+        runJob(&CURRENT);
+
+        pthread_mutex_lock(&RUN_LOCK);
+        RUN_STATE = RUN_DONE;
+        if (write(WAKE_PIPE[1], "", 1) < 0)
+            perror("runner wake");
+    }
+    pthread_mutex_unlock(&RUN_LOCK);
+    return NULL;
+}
+
+/*****************************  startJob  *****************************
+ * void startJob(Client *c)
+ *
+ * Description: Takes the oldest job queued by c and hands it to the
+ * runner thread.
+ *
+ * NOTES:
+ * - Only called while the runner is idle.
+ ***********************************************************************/
+static void startJob(Client *c)
+{
+    pthread_mutex_lock(&RUN_LOCK);
+    CURRENT.job = c->queue[c->head];
+    CURRENT.client = (int) (c - CLIENTS);
+    CURRENT.serial = c->serial;
+    RUN_STATE = RUN_PENDING;
+    pthread_cond_signal(&RUN_READY);
+    pthread_mutex_unlock(&RUN_LOCK);
+
+    c->head = (c->head + 1) % MAX_QUEUED_JOBS;
+    c->count--;
+    STATS.queued--;
+}
+
+/*****************************  finishJob  *****************************
+ * int finishJob(void)
+ *
+ * Description: Collects a job the runner has finished, sends its reply
+ * and updates STATS.
+ *
+ * NOTES:
+ * - Returns 1 if a job was collected, 0 if the runner is still busy.
+ * - The reply is dropped if the client hung up while the job ran,
+ *   even if a new connection has since taken the same slot.
+ ***********************************************************************/
+static int finishJob(void)
+{
+    Client *c;
+    int done;
+
+    pthread_mutex_lock(&RUN_LOCK);
+    done = (RUN_STATE == RUN_DONE);
+    if (done)
+        RUN_STATE = RUN_IDLE;
+    pthread_mutex_unlock(&RUN_LOCK);
+    if (!done)
+        return 0;
+
+    c = &CLIENTS[CURRENT.client];
+    if (c->fd != -1 && c->serial == CURRENT.serial)
+    {
+        if (CURRENT.reply != NULL)
+            sendAll(c->fd, CURRENT.reply, CURRENT.length);
+        else
+            dprintf(c->fd, "ERR out of memory\n");
+    }
+    free(CURRENT.reply);
+    CURRENT.reply = NULL;
+
+    if (!CURRENT.ok)
+    {
+        STATS.rejected++;
+        return 1;
+    }
+    STATS.jobs++;
+    STATS.totalService += CURRENT.service;
+    STATS.totalWait += CURRENT.start - CURRENT.job.queuedAt;
+    if (CURRENT.service > STATS.maxService)
+        STATS.maxService = CURRENT.service;
+    return 1;
+}
+
+/*****************************  runServer  *****************************
+ * int runServer(const char *socketPath)
+ *
+ * Description: Daemon main loop.
+ *
+ * Process:
+ * 1.) Bind and listen on socketPath.
+ * 2.) Start the runner thread.
+ * 3.) Poll the listener, every client and the runner's wake pipe.  New
+ *     connections take a free slot, readable clients have their
+ *     requests parsed and queued or answered, and a finished job has
+ *     its reply sent.
+ * 4.) If the runner is idle and any job is queued, hand it one job from
+ *     the next client in round-robin order and go back to 3.
+ * 5.) After a SHUTDOWN request, stop once the queues are empty and the
+ *     last job has been answered, join the runner and remove the socket
+ *     file.
+ *
+ * Parameter    Direction   Description
+ * --------------------------------------------------------------------
+ * socketPath   in          filesystem path of the Unix domain socket
+ *
+ * NOTES:
+ * - Requires spinUpThreads to have been called.
+ * - Returns 0 after SHUTDOWN, GENERIC_ERROR_CODE if the socket can't be
+ *   set up.
+ ***********************************************************************/
+int runServer(const char *socketPath)
+{
+    int i, k;
+    int listener;
+    int ready;
+    int nextClient = 0;
+    int busy = 0;               // a job is with the runner
+    char drain[64];
+    struct sockaddr_un addr;
+    struct pollfd fds[MAX_CLIENTS + 2];
+    pthread_t runner;
+    Client *c;
+
+    if (strlen(socketPath) >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, "socket path too long: %s\n", socketPath);
+        return GENERIC_ERROR_CODE;
+    }
+
+    // a client hanging up mid-reply must not kill the daemon
+    signal(SIGPIPE, SIG_IGN);
+
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+    {
+        perror("socket");
+        return GENERIC_ERROR_CODE;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socketPath);
+    unlink(socketPath);
+    if (bind(listener, (struct sockaddr *) &addr, sizeof(addr)) < 0 ||
+        listen(listener, MAX_CLIENTS) < 0)
+    {
+        perror(socketPath);
+        close(listener);
+        return GENERIC_ERROR_CODE;
+    }
+
+    for (i = 0; i < MAX_CLIENTS; i++)
+        CLIENTS[i].fd = -1;
+
+    if (pipe(WAKE_PIPE) != 0 ||
+        pthread_create(&runner, NULL, runnerMain, NULL) != 0)
+    {
+        perror("runner");
+        if (WAKE_PIPE[0] != -1)
+        {
+            close(WAKE_PIPE[0]);
+            close(WAKE_PIPE[1]);
+        }
+        close(listener);
+        unlink(socketPath);
+        return GENERIC_ERROR_CODE;
+    }
+
+    while (!SHUTDOWN_REQUESTED || STATS.queued > 0 || busy)
+    {
+        fds[0].fd = listener;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = WAKE_PIPE[0];
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+        for (i = 0; i < MAX_CLIENTS; i++)
+        {
+            fds[i + 2].fd = CLIENTS[i].fd;
+            fds[i + 2].events = POLLIN;
+            fds[i + 2].revents = 0;
+        }
+
+        ready = poll(fds, MAX_CLIENTS + 2, -1);
+        if (ready < 0 && errno != EINTR)
+        {
+            perror("poll");
+            break;
+        }
+
+        if (ready > 0 && (fds[1].revents & POLLIN))
+        {
+            if (read(WAKE_PIPE[0], drain, sizeof(drain)) < 0)
+                perror("runner wake");
+            if (finishJob())
+                busy = 0;
+        }
+
+        if (ready > 0 && (fds[0].revents & POLLIN))
+        {
+            int fd = accept(listener, NULL, NULL);
+            for (i = 0; fd >= 0 && i < MAX_CLIENTS; i++)
+            {
+                if (CLIENTS[i].fd == -1)
+                {
+                    CLIENTS[i].fd = fd;
+                    CLIENTS[i].serial = NEXT_SERIAL++;
+                    fd = -1;
+                }
+            }
+            if (fd >= 0)
+            {
+                dprintf(fd, "ERR too many clients\n");
+                close(fd);
+            }
+        }
+
+        for (i = 0; ready > 0 && i < MAX_CLIENTS; i++)
+        {
+            if (CLIENTS[i].fd != -1 && fds[i + 2].fd == CLIENTS[i].fd &&
+                (fds[i + 2].revents & (POLLIN | POLLHUP | POLLERR)))
+                readClient(&CLIENTS[i]);
+        }
+
+        // one job at a time, round-robin over clients with queued work
+        for (k = 0; !busy && k < MAX_CLIENTS && STATS.queued > 0; k++)
+        {
+            c = &CLIENTS[(nextClient + k) % MAX_CLIENTS];
+            if (c->fd == -1 || c->count == 0)
+                continue;
+            startJob(c);
+            busy = 1;
+            nextClient = (nextClient + k + 1) % MAX_CLIENTS;
+        }
+    }
+
+    pthread_mutex_lock(&RUN_LOCK);
+    RUNNER_EXIT = 1;
+    pthread_cond_signal(&RUN_READY);
+    pthread_mutex_unlock(&RUN_LOCK);
+    pthread_join(runner, NULL);
+    close(WAKE_PIPE[0]);
+    close(WAKE_PIPE[1]);
+
+    for (i = 0; i < MAX_CLIENTS; i++)
+        if (CLIENTS[i].fd != -1)
+            dropClient(&CLIENTS[i]);
+    close(listener);
+    unlink(socketPath);
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <string.h>
+#include "define.h"
+
+/*****************************  clearStats  ****************************
+ * void clearStats(GenStats *stats)
+ *
+ * Description: Zeroes every counter in stats.
+ ***********************************************************************/
+void clearStats(GenStats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+/******************************  addStats  *****************************
+ * void addStats(GenStats *total, const GenStats *part)
+ *
+ * Description: Adds the counters of part into total.  Used to reduce
+ * the per-thread accumulators once a generation is finished.
+ *
+ * Parameter    Direction   Description
+ * --------------------------------------------------------------------
+ * total        in/out      running totals
+ * part         in          one thread's counters
+ ***********************************************************************/
+void addStats(GenStats *total, const GenStats *part)
+{
+    int k;
+    total->sum += part->sum;
+    total->zeros += part->zeros;
+    for (k = 0; k < HIST_BINS; k++)
+        total->hist[k] += part->hist[k];
+    for (k = 0; k < NUM_RULES; k++)
+        total->rules[k] += part->rules[k];
+}
+
+/**************************  writeStatsHeader  *************************
+ * void writeStatsHeader(FILE *out)
+ *
+ * Description: Writes the CSV column names matching writeStatsRow.
+ ***********************************************************************/
+void writeStatsHeader(FILE *out)
+{
+    int k;
+    fprintf(out, "generation,sum,zeros,rule_zero,rule_add,rule_subtract,rule_one");
+    for (k = 0; k < HIST_BINS; k++)
+        fprintf(out, ",hist_%d", k * HIST_WIDTH);
+    fprintf(out, "\n");
+}
+
+/***************************  writeStatsRow  ***************************
+ * void writeStatsRow(FILE *out, int generation, const GenStats *stats)
+ *
+ * Description: Writes one CSV line of the statistics time series.
+ *
+ * Parameter    Direction   Description
+ * --------------------------------------------------------------------
+ * out          in          stream receiving the line
+ * generation   in          generation the statistics belong to
+ * stats        in          reduced statistics of that generation
+ ***********************************************************************/
+void writeStatsRow(FILE *out, int generation, const GenStats *stats)
+{
+    int k;
+    fprintf(out, "%d,%lld,%ld", generation, stats->sum, stats->zeros);
+    for (k = 0; k < NUM_RULES; k++)
+        fprintf(out, ",%ld", stats->rules[k]);
+    for (k = 0; k < HIST_BINS; k++)
+        fprintf(out, ",%ld", stats->hist[k]);
+    fprintf(out, "\n");
+}
@@ -0,0 +1,304 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include "define.h"
+/***********************************************************************
+ * tune.c written by DSU_410 team ...
+ *
+ * Description: Startup autotuner (-a) and its persisted profile.
+ *
+ * The tuner times TUNE_GENERATIONS generations of the real grid in B for
+ * each candidate setting and keeps the fastest, one setting at a time:
+ * 1.) kernel (every supported, validated entry of KERNELS)
+ * 2.) thread count (powers of two and the online CPU count, never more
+ *     than there are interior rows)
+ * 3.) partition granularity, CHUNK_ROWS (static strips or dynamically
+ *     claimed chunks; in-place mode only supports static strips)
+ * B is restored after every candidate, so the run that follows starts
+ * from the same values it would have without tuning.
+ *
+ * Profile file, one line per host and grid shape:
+ *   <host> <shape> <mode> <threads> <chunk> <kernel>
+ * shape is the interior size rounded up to powers of two (e.g. 4x4),
+ * mode is "twogrid" or "inplace".  Later runs on the same host with the
+ * same shape class and mode load the line instead of tuning again.
+ ***********************************************************************/
+
+/*****************************  nextPow2  *****************************
+ * int nextPow2(int n)
+ *
+ * Description: Smallest power of two greater than or equal to n.
+ ***********************************************************************/
+static int nextPow2(int n)
+{
+    int p = 1;
+    while (p < n)
+        p *= 2;
+    return p;
+}
+
+/*****************************  profileKey  *****************************
+ * void profileKey(char *host, int hostSize, char *shape, int shapeSize)
+ *
+ * Description: Fills in the host and shape class fields identifying
+ * this run's line in the profile.
+ ***********************************************************************/
+static void profileKey(char *host, int hostSize, char *shape, int shapeSize)
+{
+    if (gethostname(host, hostSize) != 0)
+        strcpy(host, "unknown");
+    host[hostSize - 1] = '\0';
+    snprintf(shape, shapeSize, "%dx%d", nextPow2(M - 2), nextPow2(N - 2));
+}
+
+/*****************************  timeCandidate  *****************************
+ * long long timeCandidate(int saved[][N])
+ *
+ * Description: Runs TUNE_GENERATIONS generations with the current
+ * settings and returns the fastest single generation in microseconds.
+ *
+ * Parameter    Direction   Description
+ * --------------------------------------------------------------------
+ * saved        in          copy of the starting grid, put back into B
+ *                          afterwards
+ *
+ * NOTES:
+ * - Starts and stops its own thread pool, since THREAD_COUNT may only
+ *   change while the pool is down.
+ * - Using the fastest generation rather than the total keeps a single
+ *   descheduled generation from deciding the result.
+ ***********************************************************************/
+static long long timeCandidate(int saved[][N])
+{
+    int g;
+    long long start, elapsed;
+    long long best = LLONG_MAX;
+
+    spinUpThreads();
+    for (g = 0; g < TUNE_GENERATIONS; g++)
+    {
+        start = nowMicros();
+        computeGeneration();
+        elapsed = nowMicros() - start;
+        if (elapsed < best)
+            best = elapsed;
+        if (B != A)
+            copyArray(M, N, A, B);
+    }
+    spinDownThreads();
+
+    copyArray(M, N, saved, B);
+    return best;
+}
+
+/*******************************  autotune  *******************************
+ * void autotune(int tuneKernel, int tuneThreads, int tuneChunk)
+ *
+ * Description: Picks ROW_KERNEL, THREAD_COUNT and CHUNK_ROWS for the
+ * grid currently in B, see the description at the top of this file.
+ *
+ * Parameter    Direction   Description
+ * --------------------------------------------------------------------
+ * tuneKernel   in          0 keeps the current kernel (forced with -k)
+ * tuneThreads  in          0 keeps the current THREAD_COUNT (-t)
+ * tuneChunk    in          0 keeps the current CHUNK_ROWS (-c)
+ *
+ * NOTES:
+ * - Must be called while the thread pool is down.
+ * - Statistics are not collected during trial generations.
+ ***********************************************************************/
+void autotune(int tuneKernel, int tuneThreads, int tuneChunk)
+{
+    int k, t, chunk;
+    int candidates[32];
+    int count = 0;
+    int rows = M - 2;
+    int limit = (rows < MAX_THREADS) ? rows : MAX_THREADS;
+    int cpus = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    int bestKernel = -1, bestThreads = THREAD_COUNT, bestChunk = CHUNK_ROWS;
+    long long elapsed, best;
+    int (*saved)[N] = arenaAcquire(M * sizeof(*saved));
+    FILE *statsOut = STATS_OUT;
+
+    if (saved == NULL)
+    {
+        fprintf(stderr, "autotune: out of memory, keeping defaults\n");
+        return;
+    }
+    STATS_OUT = NULL;
+    copyArray(M, N, B, saved);
+
+    // 1.) kernel, with the default partition
+    if (tuneKernel)
+    {
+        best = LLONG_MAX;
+        for (k = 0; k < NUM_KERNELS; k++)
+        {
+            if (!KERNELS[k].supported() || !validateKernel(KERNELS[k].run))
+                continue;
+            ROW_KERNEL = KERNELS[k].run;
+            elapsed = timeCandidate(saved);
+            if (elapsed < best)
+            {
+                best = elapsed;
+                bestKernel = k;
+            }
+        }
+        ROW_KERNEL = KERNELS[bestKernel].run;
+        ROW_KERNEL_NAME = KERNELS[bestKernel].name;
+    }
+
+    // 2.) thread count, with static strips
+    if (tuneThreads)
+    {
+        best = LLONG_MAX;
+        CHUNK_ROWS = 0;
+        for (t = 1; t <= limit; t *= 2)
+            candidates[count++] = t;
+        // sysconf returns -1 when the CPU count is unknown
+        if (cpus > 0 && cpus <= limit && cpus != nextPow2(cpus))
+            candidates[count++] = cpus;
+
+        for (t = 0; t < count; t++)
+        {
+            THREAD_COUNT = candidates[t];
+            elapsed = timeCandidate(saved);
+            if (elapsed < best)
+            {
+                best = elapsed;
+                bestThreads = candidates[t];
+            }
+        }
+        THREAD_COUNT = bestThreads;
+        CHUNK_ROWS = bestChunk;
+    }
+
+    // 3.) partition granularity for the chosen thread count
+    if (tuneChunk && !IN_PLACE)
+    {
+        best = LLONG_MAX;
+        for (chunk = 0; chunk < rows; chunk = (chunk == 0) ? 1 : chunk * 4)
+        {
+            CHUNK_ROWS = chunk;
+            elapsed = timeCandidate(saved);
+            if (elapsed < best)
+            {
+                best = elapsed;
+                bestChunk = chunk;
+            }
+        }
+        CHUNK_ROWS = bestChunk;
+    }
+
+    STATS_OUT = statsOut;
+    arenaRelease(saved);
+    fprintf(stderr, "autotune: kernel %s, %d threads, chunk %d\n",
+            ROW_KERNEL_NAME, THREAD_COUNT, CHUNK_ROWS);
+}
+
+/*****************************  loadProfile  *****************************
+ * int loadProfile(const char *path)
+ *
+ * Description: Applies the settings saved for this host, shape class
+ * and mode, if the profile has them.
+ *
+ * Parameter    Direction   Description
+ * --------------------------------------------------------------------
+ * path         in          profile file
+ *
+ * NOTES:
+ * - Returns 0 if a matching line was applied, ERROR_FILE if there is
+ *   no file or no matching line, GENERIC_ERROR_CODE if the line names
+ *   a kernel this host can't run (THREAD_COUNT and CHUNK_ROWS are
+ *   still applied).
+ ***********************************************************************/
+int loadProfile(const char *path)
+{
+    char host[256], shape[32];
+    char lineHost[256], lineShape[32], lineMode[16], lineKernel[32];
+    char line[MAX_LINE];
+    int threads, chunk;
+    int status = ERROR_FILE;
+    FILE *in = fopen(path, "r");
+
+    if (in == NULL)
+        return ERROR_FILE;
+    profileKey(host, sizeof(host), shape, sizeof(shape));
+
+    while (fgets(line, sizeof(line), in) != NULL)
+    {
+        if (sscanf(line, "%255s %31s %15s %d %d %31s", lineHost, lineShape,
+                   lineMode, &threads, &chunk, lineKernel) != 6)
+            continue;
+        if (strcmp(lineHost, host) != 0 || strcmp(lineShape, shape) != 0 ||
+            strcmp(lineMode, IN_PLACE ? "inplace" : "twogrid") != 0)
+            continue;
+        if (threads < 1 || threads > MAX_THREADS || chunk < 0)
+            continue;
+
+        THREAD_COUNT = threads;
+        CHUNK_ROWS = chunk;
+        status = (selectKernel(lineKernel) == 0) ? 0 : GENERIC_ERROR_CODE;
+    }
+    fclose(in);
+    return status;
+}
+
+/*****************************  saveProfile  *****************************
+ * int saveProfile(const char *path)
+ *
+ * Description: Stores the current settings as this host, shape class
+ * and mode's line, replacing an older line with the same key.
+ *
+ * Process:
+ * 1.) Copy every other line of the old profile into path.tmp.
+ * 2.) Append the new line and rename path.tmp over path, so readers
+ *     never see a half written profile.
+ *
+ * Parameter    Direction   Description
+ * --------------------------------------------------------------------
+ * path         in          profile file, created if missing
+ *
+ * NOTES:
+ * - Returns 0 on success, ERROR_FILE otherwise.
+ ***********************************************************************/
+int saveProfile(const char *path)
+{
+    char host[256], shape[32];
+    char lineHost[256], lineShape[32], lineMode[16];
+    char line[MAX_LINE];
+    char tmpPath[MAX_PATH_LEN + 8];
+    const char *mode = IN_PLACE ? "inplace" : "twogrid";
+    FILE *in, *out;
+
+    profileKey(host, sizeof(host), shape, sizeof(shape));
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    out = fopen(tmpPath, "w");
+    if (out == NULL)
+        return ERROR_FILE;
+
+    in = fopen(path, "r");
+    if (in != NULL)
+    {
+        while (fgets(line, sizeof(line), in) != NULL)
+        {
+            if (sscanf(line, "%255s %31s %15s", lineHost, lineShape, lineMode) == 3 &&
+                strcmp(lineHost, host) == 0 && strcmp(lineShape, shape) == 0 &&
+                strcmp(lineMode, mode) == 0)
+                continue;
+            fputs(line, out);
+        }
+        fclose(in);
+    }
+
+    fprintf(out, "%s %s %s %d %d %s\n", host, shape, mode,
+            THREAD_COUNT, CHUNK_ROWS, ROW_KERNEL_NAME);
+    if (fclose(out) != 0 || rename(tmpPath, path) != 0)
+    {
+        unlink(tmpPath);
+        return ERROR_FILE;
+    }
+    return 0;
+}